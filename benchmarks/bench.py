@@ -0,0 +1,368 @@
+#
+# Benchmarks for the _ped and parted hot paths, run against sparse image
+# files so that no real disks are needed.
+#
+# Copyright (C) 2015  Red Hat, Inc.
+#
+# This copyrighted material is made available to anyone wishing to use,
+# modify, copy, or redistribute it subject to the terms and conditions of
+# the GNU General Public License v.2, or (at your option) any later version.
+# This program is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY expressed or implied, including the implied warranties of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+# Public License for more details.  You should have received a copy of the
+# GNU General Public License along with this program; if not, write to the
+# Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+# 02110-1301, USA.  Any Red Hat trademarks that are incorporated in the
+# source code or documentation are not subject to the GNU General Public
+# License and may only be used or replicated with the express permission of
+# Red Hat, Inc.
+#
+
+"""Usage: bench.py [-o FILE] [-r REPEAT] [-k PATTERN] [-c BASELINE [-t PCT]]
+
+Time the _ped and parted hot paths and write the results as JSON to FILE,
+or to standard output, along with how many times slower the parted layer
+is than _ped for the same work.  With -c, compare against a BASELINE file
+written by an earlier run and exit with status 1 if any benchmark or ratio
+got more than PCT percent (default 10) worse."""
+
+import getopt
+import json
+import os
+import platform
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+import _ped
+import parted
+
+MiB = 1024 * 1024
+GiB = 1024 * MiB
+
+# Image sizes used for the device benchmarks.  The files are sparse, so only
+# the sectors that are written take up space.
+DEVICE_SIZES = [("64MiB", 64 * MiB), ("1GiB", GiB), ("64GiB", 64 * GiB)]
+
+# Partition counts used for the label benchmarks.
+PARTITION_COUNTS = [4, 32, 128]
+
+# time.perf_counter() is not in Python 2.
+clock = getattr(time, "perf_counter", time.time)
+
+def makeImage(directory, name, size):
+    """Create a sparse image file of size bytes and return its path."""
+    path = os.path.join(directory, name)
+    with open(path, "wb") as f:
+        f.truncate(size)
+    return path
+
+def addPartitions(disk, count, slot=4096):
+    """Add count partitions of half a slot each to a fresh Disk, one per
+       slot of sectors after the first MiB.  msdos labels with more than four
+       partitions get three primaries and an extended partition holding the
+       rest as logical partitions, each with room for its EBR in front."""
+    device = disk.device
+    first = MiB // device.sectorSize
+
+    def add(ty, start, length):
+        geometry = parted.Geometry(device=device, start=start, length=length)
+        partition = parted.Partition(disk=disk, type=ty, geometry=geometry)
+        disk.addPartition(partition=partition,
+                          constraint=parted.Constraint(exactGeom=geometry))
+
+    if disk.type == "msdos" and count > 4:
+        for i in range(3):
+            add(parted.PARTITION_NORMAL, first + i * slot, slot // 2)
+
+        start = first + 3 * slot
+        add(parted.PARTITION_EXTENDED, start, (count - 3) * slot)
+
+        for i in range(3, count):
+            add(parted.PARTITION_LOGICAL, first + i * slot + slot // 2, slot // 2)
+    else:
+        for i in range(count):
+            add(parted.PARTITION_NORMAL, first + i * slot, slot // 2)
+
+def makeLabeled(directory, label, count):
+    """Create an image holding a label of the given type with count
+       partitions and return its path."""
+    path = makeImage(directory, "%s-%d.img" % (label, count), GiB)
+    device = parted.getDevice(path)
+    disk = parted.freshDisk(device, label)
+
+    if label == "gpt" and count > disk.maxPrimaryPartitionCount:
+        raise ValueError("gpt labels hold at most %d partitions" %
+                         disk.maxPrimaryPartitionCount)
+
+    addPartitions(disk, count)
+    disk.commit()
+    return path
+
+def mkfs(directory, name):
+    """Return the path of an image with an ext4 filesystem on it, or None
+       if mke2fs is not available."""
+    mke2fs = shutil.which("mke2fs") if hasattr(shutil, "which") else None
+    if mke2fs is None:
+        return None
+
+    path = makeImage(directory, name, 64 * MiB)
+    with open(os.devnull, "w") as null:
+        if subprocess.call([mke2fs, "-F", "-q", "-t", "ext4", path],
+                           stdout=null, stderr=null) != 0:
+            return None
+
+    return path
+
+class Runner(object):
+    """Times callables and collects the results."""
+    def __init__(self, repeat, pattern=None):
+        self.repeat = repeat
+        self.pattern = pattern
+        self.results = {}
+        self.ratios = {}
+
+    def wanted(self, name):
+        return self.pattern is None or self.pattern in name
+
+    def time(self, name, fn, number=1, setup=None):
+        """Run fn number times per sample, after calling setup (outside the
+           timed region) if given, and record the per-call timings of
+           self.repeat samples under name."""
+        if not self.wanted(name):
+            return
+
+        samples = []
+        for _ in range(self.repeat):
+            if setup is not None:
+                setup()
+
+            start = clock()
+            for _ in range(number):
+                fn()
+            samples.append((clock() - start) / number)
+
+        samples.sort()
+        self.results[name] = {"min": samples[0],
+                              "median": samples[len(samples) // 2],
+                              "max": samples[-1],
+                              "samples": len(samples),
+                              "number": number}
+        sys.stderr.write("%-48s %12.1f us\n" % (name, samples[0] * 1e6))
+
+    def ratio(self, name, slow, fast):
+        """Record how many times slower benchmark slow is than fast under
+           name, if both were run.  Stored like a result, so that compare()
+           works on ratios too."""
+        if slow not in self.results or fast not in self.results:
+            return
+
+        ratio = self.results[slow]["min"] / self.results[fast]["min"]
+        self.ratios[name] = {"min": ratio}
+        sys.stderr.write("%-48s %12.2fx\n" % (name, ratio))
+
+def benchImport(runner):
+    # A fresh interpreter each time, so nothing is cached.
+    cmd = [sys.executable, "-c", "import parted"]
+    runner.time("import.parted", lambda: subprocess.check_call(cmd))
+
+def benchDevices(runner, directory):
+    for (name, size) in DEVICE_SIZES:
+        # libparted caches devices by path, so every sample gets a new image
+        # to make sure the whole probe is measured.
+        paths = []
+        fresh = lambda: paths.append(makeImage(directory, "device-%s-%d.img" %
+                                               (name, len(paths)), size))
+        runner.time("getDevice.%s" % name, lambda: parted.getDevice(paths[-1]),
+                    setup=fresh)
+
+        device = parted.getDevice(makeImage(directory, "device-%s.img" % name,
+                                            size))
+        runner.time("constraint.optimal.%s" % name,
+                    lambda: device.optimalAlignedConstraint, number=100)
+
+        constraint = device.optimalAlignedConstraint
+        geometry = parted.Geometry(device=device, start=0,
+                                   length=device.length // 2)
+        runner.time("constraint.solveMax.%s" % name,
+                    lambda: constraint.solveMax(), number=100)
+        runner.time("constraint.solveNearest.%s" % name,
+                    lambda: constraint.solveNearest(geometry), number=100)
+
+    path = makeImage(directory, "read.img", 64 * MiB)
+    device = parted.getDevice(path)
+    geometry = parted.Geometry(device=device, start=0, length=device.length)
+
+    def read(count):
+        device.open()
+        try:
+            for offset in range(0, 8192, count):
+                geometry.read(offset, count)
+        finally:
+            device.close()
+
+    for count in [1, 64, 2048]:
+        runner.time("geometry.read.%d" % count, lambda: read(count))
+
+def walkPed(device):
+    """List (number, start, end) for each partition on device using _ped."""
+    disk = _ped.disk_new(device)
+    skip = (_ped.PARTITION_FREESPACE | _ped.PARTITION_METADATA |
+            _ped.PARTITION_PROTECTED)
+    found = []
+
+    part = disk.next_partition()
+    while part:
+        if not part.type & skip:
+            found.append((part.num, part.geom.start, part.geom.end))
+        part = disk.next_partition(part)
+
+    return found
+
+def walkParted(device):
+    """List (number, start, end) for each partition on device using parted."""
+    return [(p.number, p.geometry.start, p.geometry.end)
+            for p in parted.newDisk(device).partitions]
+
+def benchLabels(runner, directory):
+    for label in ["msdos", "gpt"]:
+        for count in PARTITION_COUNTS:
+            tag = "%s.%d" % (label, count)
+            path = makeLabeled(directory, label, count)
+            device = parted.getDevice(path)
+
+            runner.time("newDisk.%s" % tag, lambda: parted.newDisk(device))
+
+            # The same enumeration through both layers, to keep the cost of
+            # the parted wrappers in view.
+            runner.time("enumerate._ped.%s" % tag,
+                        lambda: walkPed(device.getPedDevice()))
+            runner.time("enumerate.parted.%s" % tag,
+                        lambda: walkParted(device))
+            runner.ratio("enumerate.%s" % tag, "enumerate.parted.%s" % tag,
+                         "enumerate._ped.%s" % tag)
+
+            disk = parted.newDisk(device)
+            runner.time("partitions.%s" % tag,
+                        lambda: [(p.number, p.geometry.start, p.geometry.end)
+                                 for p in disk.partitions], number=10)
+            runner.time("getFreeSpaceRegions.%s" % tag,
+                        disk.getFreeSpaceRegions)
+
+            def addAndCommit():
+                fresh = parted.freshDisk(device, label)
+                addPartitions(fresh, count)
+                fresh.commit()
+
+            runner.time("addPartition.commit.%s" % tag, addAndCommit)
+
+def benchProbes(runner, directory):
+    path = mkfs(directory, "ext4.img")
+    if path is None:
+        sys.stderr.write("mke2fs not found, skipping filesystem probes\n")
+        return
+
+    device = parted.getDevice(path)
+    geometry = parted.Geometry(device=device, start=0, length=device.length)
+    probe = lambda: parted.probeFileSystem(geometry)
+
+    enabled = _ped.file_system_probe_cache(False)
+    try:
+        runner.time("probeFileSystem.ext4", probe, number=10)
+
+        _ped.file_system_probe_cache(True)
+        probe()
+        runner.time("probeFileSystem.ext4.cached", probe, number=10)
+    finally:
+        _ped.file_system_probe_cache(enabled)
+
+def environment():
+    """Describe what was benchmarked, so that results can be matched up."""
+    env = {"python": platform.python_version(),
+           "platform": platform.platform(),
+           "versions": parted.version(),
+           "time": time.strftime("%Y-%m-%dT%H:%M:%SZ", time.gmtime())}
+
+    try:
+        with open(os.devnull, "w") as null:
+            env["commit"] = subprocess.check_output(
+                ["git", "rev-parse", "HEAD"], stderr=null,
+                cwd=os.path.dirname(os.path.abspath(__file__))).decode().strip()
+    except (OSError, subprocess.CalledProcessError):
+        pass
+
+    return env
+
+def compare(baseline, results, threshold):
+    """Print how each benchmark changed against baseline and return the
+       names of those more than threshold percent slower."""
+    slower = []
+
+    for name in sorted(results):
+        if name not in baseline:
+            continue
+
+        old = baseline[name]["min"]
+        new = results[name]["min"]
+        change = (new - old) * 100.0 / old if old else 0.0
+        flag = ""
+
+        if change > threshold:
+            slower.append(name)
+            flag = "  REGRESSION"
+
+        sys.stderr.write("%-48s %+8.1f%%%s\n" % (name, change, flag))
+
+    return slower
+
+def main(argv):
+    try:
+        (opts, _args) = getopt.getopt(argv, "ho:r:k:c:t:")
+    except getopt.GetoptError as e:
+        sys.stderr.write("%s\n%s\n" % (e, __doc__))
+        return 2
+
+    opts = dict(opts)
+    if "-h" in opts:
+        print(__doc__)
+        return 0
+
+    runner = Runner(int(opts.get("-r", 5)), opts.get("-k"))
+    directory = tempfile.mkdtemp(prefix="pyparted-bench-")
+
+    try:
+        benchImport(runner)
+        benchDevices(runner, directory)
+        benchLabels(runner, directory)
+        benchProbes(runner, directory)
+    finally:
+        shutil.rmtree(directory)
+
+    report = {"environment": environment(), "results": runner.results,
+              "ratios": runner.ratios}
+
+    if "-o" in opts:
+        with open(opts["-o"], "w") as f:
+            json.dump(report, f, indent=2, sort_keys=True)
+    else:
+        json.dump(report, sys.stdout, indent=2, sort_keys=True)
+        sys.stdout.write("\n")
+
+    if "-c" in opts:
+        with open(opts["-c"]) as f:
+            baseline = json.load(f)
+
+        threshold = float(opts.get("-t", 10))
+        slower = compare(baseline["results"], runner.results, threshold)
+        slower += compare(baseline.get("ratios", {}), runner.ratios, threshold)
+
+        if slower:
+            return 1
+
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
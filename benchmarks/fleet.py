@@ -0,0 +1,238 @@
+#
+# Fleet scale benchmark: inventory thousands of image-backed disks.
+#
+# Copyright (C) 2015  Red Hat, Inc.
+#
+# This copyrighted material is made available to anyone wishing to use,
+# modify, copy, or redistribute it subject to the terms and conditions of
+# the GNU General Public License v.2, or (at your option) any later version.
+# This program is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY expressed or implied, including the implied warranties of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+# Public License for more details.  You should have received a copy of the
+# GNU General Public License along with this program; if not, write to the
+# Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+# 02110-1301, USA.  Any Red Hat trademarks that are incorporated in the
+# source code or documentation are not subject to the GNU General Public
+# License and may only be used or replicated with the express permission of
+# Red Hat, Inc.
+#
+
+"""Usage: fleet.py [-n DISKS] [-j JOBS] [-s SEED] [-d DIR] [-o FILE]
+
+Create DISKS (default 1000) sparse image files with random msdos and GPT
+layouts, then scan all of them once in a single process and once spread
+over JOBS processes (default: one per CPU).  Throughput, peak RSS and
+memory allocated per disk are written as JSON to FILE, or to standard
+output.  Images are created in DIR and kept there if it is given.  Exits
+with status 1 if any disk did not read back with the layout written to
+it."""
+
+import getopt
+import json
+import multiprocessing
+import os
+import random
+import resource
+import shutil
+import sys
+import tempfile
+
+import parted
+
+from bench import GiB, addPartitions, clock, environment, makeImage
+
+try:
+    import tracemalloc
+except ImportError:
+    tracemalloc = None
+
+# Each layout fits comfortably on an image of this size, including the GPT
+# backup header at the end.
+IMAGE_SIZE = GiB
+
+def randomLayout(rng):
+    """Return a (label, partition count, slot size) triple."""
+    if rng.random() < 0.5:
+        return ("msdos", rng.randint(1, 16), rng.choice([2048, 4096, 8192]))
+    else:
+        return ("gpt", rng.randint(1, 128), rng.choice([2048, 4096, 8192]))
+
+def createFleet(directory, count, seed):
+    """Create count images with random layouts and return a list of
+       (path, partition count) pairs."""
+    rng = random.Random(seed)
+    fleet = []
+
+    for i in range(count):
+        (label, partitions, slot) = randomLayout(rng)
+        path = makeImage(directory, "disk-%05d.img" % i, IMAGE_SIZE)
+        disk = parted.freshDisk(parted.getDevice(path), label)
+        addPartitions(disk, partitions, slot)
+        disk.commit()
+
+        # The extended partition holding the logical ones counts too.
+        if label == "msdos" and partitions > 4:
+            partitions += 1
+
+        fleet.append((path, partitions))
+
+    return fleet
+
+def scanDisk(path):
+    """Inventory one disk the way a fleet tool would and return how many
+       partitions it has."""
+    device = parted.getDevice(path)
+    disk = parted.newDisk(device)
+    inventory = {"path": device.path,
+                 "model": device.model,
+                 "size": device.getLength("B"),
+                 "label": disk.type,
+                 "partitions": [(p.number, p.type, p.geometry.start,
+                                 p.geometry.end, p.getFlagsAsString())
+                                for p in disk.partitions],
+                 "free": [(g.start, g.end) for g in disk.getFreeSpaceRegions()]}
+    return len(inventory["partitions"])
+
+def scanAll(fleet):
+    """Scan every disk in fleet.  Returns the number of disks whose
+       partition count is wrong and the peak RSS of this process in KiB."""
+    wrong = 0
+    for (path, partitions) in fleet:
+        if scanDisk(path) != partitions:
+            wrong += 1
+
+    return (wrong, resource.getrusage(resource.RUSAGE_SELF).ru_maxrss)
+
+def traceAll(fleet):
+    """Scan every disk in fleet with allocation tracing on.  Returns the
+       peak traced Python memory in bytes and the number of Python memory
+       blocks still allocated afterwards (both None on Python 2)."""
+    blocks = getattr(sys, "getallocatedblocks", None)
+    if tracemalloc is not None:
+        tracemalloc.start()
+    before = blocks() if blocks else None
+
+    for (path, _partitions) in fleet:
+        scanDisk(path)
+
+    peak = retained = None
+    if blocks:
+        retained = blocks() - before
+    if tracemalloc is not None:
+        peak = tracemalloc.get_traced_memory()[1]
+        tracemalloc.stop()
+
+    return (peak, retained)
+
+def mapFresh(func, chunks):
+    """Run func over chunks, each in a fresh process, so that an earlier
+       scan does not affect the figures.  Returns the results and how long
+       they took."""
+    pool = multiprocessing.Pool(len(chunks), maxtasksperchild=1)
+
+    try:
+        start = clock()
+        results = pool.map(func, chunks, chunksize=1)
+        elapsed = clock() - start
+    finally:
+        pool.close()
+        pool.join()
+
+    return (results, elapsed)
+
+def runScan(fleet, jobs):
+    """Scan fleet in jobs processes and return the results.  Tracing slows
+       the scan down, so the timed pass runs without it and the Python
+       memory figures come from a second, untimed pass."""
+    chunks = [fleet[i::jobs] for i in range(jobs)]
+
+    (results, elapsed) = mapFresh(scanAll, chunks)
+    (memory, _elapsed) = mapFresh(traceAll, chunks)
+
+    wrong = sum(r[0] for r in results)
+    traced = [m[0] for m in memory if m[0] is not None]
+    retained = [m[1] for m in memory if m[1] is not None]
+
+    return {"jobs": jobs,
+            "seconds": elapsed,
+            "disks_per_second": len(fleet) / elapsed,
+            "peak_rss_kib": max(r[1] for r in results),
+            "peak_rss_kib_total": sum(r[1] for r in results),
+            "peak_traced_bytes_per_disk": sum(traced) / float(len(fleet))
+                                          if traced else None,
+            "retained_blocks_per_disk": sum(retained) / float(len(fleet))
+                                        if retained else None,
+            "wrong": wrong}
+
+def main(argv):
+    try:
+        (opts, _args) = getopt.getopt(argv, "hn:j:s:d:o:")
+    except getopt.GetoptError as e:
+        sys.stderr.write("%s\n%s\n" % (e, __doc__))
+        return 2
+
+    opts = dict(opts)
+    if "-h" in opts:
+        print(__doc__)
+        return 0
+
+    count = int(opts.get("-n", 1000))
+    jobs = int(opts.get("-j", multiprocessing.cpu_count()))
+    seed = int(opts.get("-s", 0))
+
+    if "-d" in opts:
+        directory = opts["-d"]
+        if not os.path.isdir(directory):
+            os.makedirs(directory)
+    else:
+        directory = tempfile.mkdtemp(prefix="pyparted-fleet-")
+
+    try:
+        # libparted caches every device it opens, so the images are created
+        # in a child process and the scanners do not inherit that cache.
+        pool = multiprocessing.Pool(1)
+        try:
+            start = clock()
+            fleet = pool.apply(createFleet, (directory, count, seed))
+            created = clock() - start
+        finally:
+            pool.close()
+            pool.join()
+
+        sys.stderr.write("created %d disks in %.1fs\n" % (count, created))
+
+        sequential = runScan(fleet, 1)
+        sys.stderr.write("sequential: %.1f disks/s\n" %
+                         sequential["disks_per_second"])
+
+        concurrent = runScan(fleet, jobs)
+        sys.stderr.write("%d jobs: %.1f disks/s\n" %
+                         (jobs, concurrent["disks_per_second"]))
+    finally:
+        if "-d" not in opts:
+            shutil.rmtree(directory)
+
+    report = {"environment": environment(),
+              "disks": count,
+              "seed": seed,
+              "create": {"seconds": created,
+                         "disks_per_second": count / created},
+              "sequential": sequential,
+              "concurrent": concurrent}
+
+    if "-o" in opts:
+        with open(opts["-o"], "w") as f:
+            json.dump(report, f, indent=2, sort_keys=True)
+    else:
+        json.dump(report, sys.stdout, indent=2, sort_keys=True)
+        sys.stdout.write("\n")
+
+    if sequential["wrong"] or concurrent["wrong"]:
+        sys.stderr.write("some disks did not read back as written\n")
+        return 1
+
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
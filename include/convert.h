@@ -39,16 +39,47 @@
 #if PY_MAJOR_VERSION < 3
 #define PyUnicode_AsUTF8 PyString_AsString
 #define TP_FLAGS (Py_TPFLAGS_HAVE_CLASS | Py_TPFLAGS_CHECKTYPES | Py_TPFLAGS_HAVE_GC | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_RICHCOMPARE)
+#define TP_FLAGS_LEAF (Py_TPFLAGS_HAVE_CLASS | Py_TPFLAGS_CHECKTYPES | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_RICHCOMPARE)
 #else
 // XXX Restore tp_richcompare?
 #define TP_FLAGS (Py_TPFLAGS_HAVE_GC | Py_TPFLAGS_BASETYPE)
+#define TP_FLAGS_LEAF (Py_TPFLAGS_BASETYPE)
 #endif
 
+/* Helpers for the tp_hash functions: fold each field into the running
+ * value with _ped_hash_add(), then pass it through _ped_hash_done(), which
+ * keeps -1 (the error return) out of the result. */
+#if PY_MAJOR_VERSION < 3
+#define Py_hash_t long
+#endif
+
+#define PED_HASH_INIT 0x345678UL
+
+static inline unsigned long _ped_hash_add(unsigned long h,
+                                          unsigned long long v) {
+    return (h ^ (unsigned long) (v ^ (v >> 32))) * 1000003UL;
+}
+
+static inline unsigned long _ped_hash_str(unsigned long h, const char *s) {
+    while (s && *s)
+        h = (h ^ (unsigned char) *s++) * 1000003UL;
+    return h;
+}
+
+static inline Py_hash_t _ped_hash_done(unsigned long h) {
+    return (h == (unsigned long) -1) ? -2 : (Py_hash_t) h;
+}
+
+Py_hash_t _ped_Device_hash(_ped_Device *);
+Py_hash_t _ped_Geometry_hash(_ped_Geometry *);
+Py_hash_t _ped_Partition_hash(_ped_Partition *);
+
 
 PedAlignment *_ped_Alignment2PedAlignment(PyObject *);
 _ped_Alignment *PedAlignment2_ped_Alignment(PedAlignment *);
 
 PedConstraint *_ped_Constraint2PedConstraint(PyObject *);
+PedConstraint *_ped_Constraint2PedConstraint_cached(PyObject *);
 _ped_Constraint *PedConstraint2_ped_Constraint(PedConstraint *);
 
 PedDevice *_ped_Device2PedDevice(PyObject *);
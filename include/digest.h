@@ -0,0 +1,47 @@
+/*
+ * digest.h
+ * Checksums computed by native code over device data
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ *
+ * This copyrighted material is made available to anyone wishing to use,
+ * modify, copy, or redistribute it subject to the terms and conditions of
+ * the GNU General Public License v.2, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY expressed or implied, including the implied warranties of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.  You should have received a copy of the
+ * GNU General Public License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.  Any Red Hat trademarks that are incorporated in the
+ * source code or documentation are not subject to the GNU General Public
+ * License and may only be used or replicated with the express permission of
+ * Red Hat, Inc.
+ */
+
+#ifndef DIGEST_H_INCLUDED
+#define DIGEST_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Running XXH64 state, see digest_xxh64_init() */
+typedef struct {
+    uint64_t total;             /* bytes fed in so far */
+    uint64_t v[4];
+    unsigned char mem[32];      /* tail of the input not yet consumed */
+    size_t memsize;
+    uint64_t seed;
+} digest_xxh64_state;
+
+uint32_t digest_crc32c(uint32_t, const void *, size_t);
+int digest_crc32c_hw(void);
+
+void digest_xxh64_init(digest_xxh64_state *, uint64_t);
+void digest_xxh64_update(digest_xxh64_state *, const void *, size_t);
+uint64_t digest_xxh64_final(const digest_xxh64_state *);
+
+#endif /* DIGEST_H_INCLUDED */
+
+/* vim:tw=78:ts=4:et:sw=4
+ */
@@ -81,13 +81,20 @@ PyDoc_STRVAR(device_read_doc,
 "read(self, start, count) -> bool\n\n"
 "Read and return count sectors from this Device, starting at sector start.\n"
 "Both start and count are long integers and buffer is a Python object large\n"
-"enough to hold what you want to read.");
+"enough to hold what you want to read.\n\n"
+"If direct_io is set, the sectors are read with O_DIRECT through a buffer\n"
+"aligned to phys_sector_size, bypassing the page cache, and returned as\n"
+"bytes.  The O_DIRECT descriptor is opened once when direct_io is set and\n"
+"closed when it is cleared, which raises _ped.IOException while a direct\n"
+"read() or write() is still running in another thread.");
 
 PyDoc_STRVAR(device_write_doc,
 "write(self, buffer, start, count) -> bool\n\n"
 "Write count sectors from buffer to this Device, starting at sector start.\n"
 "Both start and count are long integers and buffer is a Python object holding\n"
-"what you want to write to this Device.\n\n"
+"what you want to write to this Device.  If direct_io is set, buffer may\n"
+"be any bytes-like object and is written with O_DIRECT, bypassing the page\n"
+"cache.\n\n"
 "Return True if the write was successful, False otherwise.");
 
 PyDoc_STRVAR(device_sync_doc,
@@ -107,6 +114,46 @@ PyDoc_STRVAR(device_check_doc,
 "Architecture-dependent function that returns the number of sectors on\n"
 "this Device that are ok.");
 
+PyDoc_STRVAR(device_find_signatures_doc,
+"find_signatures(self, start=0, count=-1) -> list\n\n"
+"Scan count Sectors of self beginning at start, or the whole Device by\n"
+"default, for partition table, RAID, LVM and filesystem signatures.  The\n"
+"Device is read directly in large chunks without holding the global\n"
+"interpreter lock, so self does not need to be open.  Returns a list of\n"
+"(offset, name) tuples sorted by offset, where offset is the byte position\n"
+"of the magic and name is 'dos', 'gpt', 'LVM2_member',\n"
+"'linux_raid_member' or a filesystem type name.  Beyond the first sector,\n"
+"'dos' is only reported where the four partition entries in front of the\n"
+"0x55AA look valid and at least one is in use.  Raises _ped.IOException\n"
+"if the Device cannot be read.");
+
+PyDoc_STRVAR(device_zero_range_doc,
+"zero_range(self, start, count, progress=None) -> boolean\n\n"
+"Fill count Sectors of self beginning at start with zeros.  Block devices\n"
+"use BLKZEROOUT and image files use fallocate(), so nothing needs to be\n"
+"written where the kernel or filesystem can do it; otherwise zeros are\n"
+"written in large aligned chunks.  The work is done without holding the\n"
+"global interpreter lock.  If progress is given, it is called with a\n"
+"_ped.Timer describing how far along the operation is.  Raises\n"
+"_ped.IOException on failure.");
+
+PyDoc_STRVAR(device_discard_range_doc,
+"discard_range(self, start, count, progress=None) -> boolean\n\n"
+"Tell the Device that count Sectors beginning at start are no longer in\n"
+"use, with BLKDISCARD for block devices and by punching a hole in image\n"
+"files.  Their contents are undefined afterwards.  Returns False, leaving\n"
+"the Device untouched, if it does not support discarding.  progress works\n"
+"as it does for zero_range().  Raises _ped.IOException on failure.");
+
+PyDoc_STRVAR(device_mmap_view_doc,
+"mmap_view(self, start, count, writable=False) -> memoryview\n\n"
+"Map count Sectors of self beginning at start into memory and return a\n"
+"memoryview of them, so they can be parsed without a read() per access.\n"
+"self must be an open DEVICE_FILE that is not in external access mode.\n"
+"The view is read-only unless writable is True, in which case changes go\n"
+"straight to the image file.  The mapping is released along with the last\n"
+"view of it.  Raises _ped.IOException if self cannot be mapped.");
+
 PyDoc_STRVAR(disk_clobber_doc,
 "clobber(self) -> boolean\n\n"
 "Remove all identifying information from a partition table.  If the partition\n"
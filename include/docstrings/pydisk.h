@@ -52,6 +52,22 @@ PyDoc_STRVAR(partition_is_flag_available_doc,
 "is_flag_available(self, flag) -> boolean\n\n"
 "Return whether the given flag is valid for self.");
 
+PyDoc_STRVAR(partition_get_flags_doc,
+"get_flags(self) -> integer\n\n"
+"Return the flags set on self as a bitmask, with bit 1 << flag set for each\n"
+"_ped.PARTITION_* flag that is on.  Inactive partitions have no flags and\n"
+"return 0.");
+
+PyDoc_STRVAR(partition_set_flags_doc,
+"set_flags(self, mask) -> boolean\n\n"
+"Turn on the flags whose bits are set in mask, as returned by get_flags(),\n"
+"and turn off every other flag available on self.  If mask names a flag that\n"
+"is not available, _ped.PartitionException is raised and no flag is changed.\n"
+"Some labels turn one flag off when another is turned on, as msdos does for\n"
+"RAID and LVM.  If the flags do not end up matching mask,\n"
+"_ped.PartitionException is raised and self keeps whatever flags it ended\n"
+"up with.");
+
 PyDoc_STRVAR(partition_set_system_doc,
 "set_system(self, FileSystemType) -> boolean\n\n"
 "Set the system type on self to FileSystemType.  On error,\n"
@@ -179,6 +195,19 @@ PyDoc_STRVAR(disk_is_flag_available_doc,
 "is_flag_available(self, flag) -> boolean\n\n"
 "Return whether the given flag is valid for self.");
 
+PyDoc_STRVAR(disk_get_flags_doc,
+"get_flags(self) -> integer\n\n"
+"Return the flags set on self as a bitmask, with bit 1 << flag set for each\n"
+"_ped.DISK_* flag that is on.");
+
+PyDoc_STRVAR(disk_set_flags_doc,
+"set_flags(self, mask) -> boolean\n\n"
+"Turn on the flags whose bits are set in mask, as returned by get_flags(),\n"
+"and turn off every other flag available on self.  If mask names a flag that\n"
+"is not available, _ped.DiskException is raised and no flag is changed.  If\n"
+"the label does not allow every flag in mask at once, _ped.DiskException is\n"
+"raised after the flags have been applied.");
+
 PyDoc_STRVAR(disk_add_partition_doc,
 "add_partition(self, Partition, Constraint) -> boolean\n\n"
 "Adds the new partition Partition to self.  This operation may modify the\n"
@@ -258,6 +287,28 @@ PyDoc_STRVAR(disk_extended_partition_doc,
 "If an extended partition exists on self, return it.  Otherwise, raise\n"
 "_ped.PartitionException");
 
+PyDoc_STRVAR(disk_audit_alignment_doc,
+"audit_alignment(self, Alignment=None) -> list\n\n"
+"Check every partition on self against Alignment, which defaults to the\n"
+"optimum alignment of the Device.  A partition is aligned when its start\n"
+"Sector and the Sector following its end both satisfy Alignment.  Returns a\n"
+"list of (number, start, end, aligned_start, aligned_end) tuples, one for\n"
+"each misaligned partition, where aligned_start and aligned_end are the\n"
+"nearest suitable Sectors on the Device, or -1 if there is none.");
+
+PyDoc_STRVAR(disk_probe_filesystems_doc,
+"probe_filesystems(self, workers=4) -> dict\n\n"
+"Detect the filesystem on every partition of self, skipping free space,\n"
+"metadata and extended partitions.  Well known superblocks are looked for\n"
+"and checked by up to workers threads reading the Device in parallel\n"
+"without holding the global interpreter lock.  Only FAT and HFS+ matches,\n"
+"which that filesystem's libparted probe has to confirm, partitions that\n"
+"look like more than one filesystem, and partitions not recognized at all\n"
+"are then probed by libparted, one at a time.  On a Device without 512\n"
+"byte sectors every match is confirmed.  Returns a dict mapping partition\n"
+"number to a _ped.FileSystemType, None if no filesystem was found, or a\n"
+"_ped.IOException instance if the partition could not be read.");
+
 PyDoc_STRVAR(disk_type_check_feature_doc,
 "check_feature(self, DiskTypeFeature) -> boolean\n\n"
 "Return whether or not self supports a particular partition table feature.\n"
@@ -272,7 +323,11 @@ PyDoc_STRVAR(_ped_Partition_doc,
 "Valid flags for Partitions are given by the _ped.PARTITION_* constants,\n"
 "though not all flags are valid for every disk label type.\n\n"
 "For most errors involving a Partition object, _ped.PartitionException will\n"
-"be raised.");
+"be raised.\n\n"
+"Partition objects compare by device, number, type, geometry and filesystem\n"
+"type, and hash by device and geometry.  Adding one to a disk does not change\n"
+"its hash, but moving or resizing it does, so that should not be done while\n"
+"it is a dict key or in a set.");
 
 PyDoc_STRVAR(_ped_Disk_doc,
 "A _ped.Disk object represents a disk label, or partition table, on a single\n"
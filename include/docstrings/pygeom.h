@@ -112,6 +112,41 @@ PyDoc_STRVAR(geometry_map_doc,
 "The new address is returned, or ArithmeticError is raised if Sector does\n"
 "not exist within self.");
 
+PyDoc_STRVAR(geometry_copy_to_doc,
+"copy_to(self, Geometry, chunk_sectors=2048, threads=2, progress=None)\n"
+"    -> boolean\n\n"
+"Copy the contents of self to the start of Geometry, which may be on\n"
+"another Device but must be at least as large and must not overlap self.\n"
+"The copy runs without holding the global interpreter lock, moving\n"
+"chunk_sectors Sectors at a time with up to threads threads, so that with\n"
+"two or more one chunk is being read while another is written.  Between\n"
+"two regular files the kernel is asked to copy the data with\n"
+"copy_file_range() where it can, and chunks of zeros become holes when\n"
+"Geometry is on an image file.  If progress is given, it is called with a\n"
+"_ped.Timer describing how far along the copy is.  Raises\n"
+"_ped.IOException on failure.");
+
+PyDoc_STRVAR(geometry_diff_doc,
+"diff(self, Geometry, chunk_sectors=2048, threads=2, progress=None) -> list\n\n"
+"Compare the contents of self with Geometry, which must be the same size,\n"
+"chunk_sectors Sectors at a time.  Chunks are read and compared by up to\n"
+"threads threads without holding the global interpreter lock.  Returns a\n"
+"list of (start, length) tuples, in Sectors from the start of self, that\n"
+"cover the chunks that differ; neighbouring chunks are merged into one\n"
+"range.  progress works as it does for copy_to().  Raises\n"
+"_ped.IOException if either Device cannot be read.");
+
+PyDoc_STRVAR(geometry_digest_doc,
+"digest(self, algorithm='sha256', chunk_sectors=2048, chunks=False)\n"
+"    -> string or list\n\n"
+"Return the hex digest of the contents of self, read chunk_sectors Sectors\n"
+"at a time without holding the global interpreter lock.  algorithm is\n"
+"'crc32c', 'xxh64' or 'sha256'.  CRC32C uses the CPU's crc32 instruction\n"
+"where there is one and SHA-256 is computed by hashlib.  If chunks is\n"
+"True, return a list with a digest of each chunk instead, for finding\n"
+"duplicate or changed blocks; the last chunk may be shorter than the\n"
+"others.  Raises _ped.IOException if the Device cannot be read.");
+
 PyDoc_STRVAR(_ped_Geometry_doc,
 "A _ped.Geometry object describes a continuous region on a physical device.\n"
 "This device is given by the dev attribute when the Geometry is created.\n"
@@ -124,7 +159,9 @@ PyDoc_STRVAR(_ped_Geometry_doc,
 "\t- start + length - 1 == end\n"
 "\t- length > 0\n"
 "\t- start >= 0\n"
-"\t- end < dev.length");
+"\t- end < dev.length\n\n"
+"Geometry objects compare and hash by device, start and length, so one\n"
+"should not be changed while it is a dict key or in a set.");
 
 #endif /* DOCSTRINGS_PYGEOM_H_INCLUDED */
 
@@ -67,6 +67,27 @@ PyDoc_STRVAR(alignment_is_aligned_doc,
 "alignment constraint.  This method defines what 'satisfy' means for\n"
 "intersection.");
 
+PyDoc_STRVAR(alignment_align_up_many_doc,
+"align_up_many(self, Geometry, sectors) -> array('q')\n\n"
+"Batch form of align_up().  sectors is any buffer of signed 64-bit\n"
+"integers, such as an array('q').  Returns a new array('q') with one result\n"
+"per input Sector, or -1 where no aligned Sector exists inside Geometry.");
+
+PyDoc_STRVAR(alignment_align_down_many_doc,
+"align_down_many(self, Geometry, sectors) -> array('q')\n\n"
+"Batch form of align_down().  See align_up_many() for the arguments and\n"
+"return value.");
+
+PyDoc_STRVAR(alignment_align_nearest_many_doc,
+"align_nearest_many(self, Geometry, sectors) -> array('q')\n\n"
+"Batch form of align_nearest().  See align_up_many() for the arguments and\n"
+"return value.");
+
+PyDoc_STRVAR(alignment_is_aligned_many_doc,
+"is_aligned_many(self, Geometry, sectors) -> array('q')\n\n"
+"Batch form of is_aligned().  Returns a new array('q') holding 1 for each\n"
+"Sector that is aligned and inside Geometry and 0 otherwise.");
+
 PyDoc_STRVAR(_ped_Alignment_doc,
 "A _ped.Alignment object describes constraints on how sectors and Geometry\n"
 "objects are aligned.  It includes a variety of methods for aligning sectors\n"
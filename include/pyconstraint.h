@@ -42,6 +42,12 @@ PyObject *py_ped_constraint_is_solution(PyObject *, PyObject *);
 PyObject *py_ped_constraint_any(PyObject *, PyObject *);
 PyObject *py_ped_constraint_exact(PyObject *, PyObject *);
 
+/* optional memo for solve_max() and solve_nearest() */
+PyObject *py_ped_constraint_solver_cache(PyObject *, PyObject *);
+PyObject *py_ped_constraint_solver_cache_clear(PyObject *, PyObject *);
+PyObject *py_ped_constraint_solver_cache_info(PyObject *, PyObject *);
+void constraint_solver_cache_flush(void);
+
 /* _ped.Constraint type is the Python equiv of PedConstraint in libparted */
 typedef struct {
     PyObject_HEAD
@@ -53,6 +59,9 @@ typedef struct {
     PyObject *end_range;                /* _ped.Geometry  */
     long long min_size;                 /* PedSector      */
     long long max_size;                 /* PedSector      */
+
+    /* cached PedConstraint built from the members above, or NULL */
+    PedConstraint *ped_constraint;
 } _ped_Constraint;
 
 void _ped_Constraint_dealloc(_ped_Constraint *);
@@ -64,6 +73,7 @@ int _ped_Constraint_clear(_ped_Constraint *);
 int _ped_Constraint_init(_ped_Constraint *, PyObject *, PyObject *);
 PyObject *_ped_Constraint_get(_ped_Constraint *, void *);
 int _ped_Constraint_set(_ped_Constraint *, PyObject *, void *);
+void _ped_Constraint_invalidate(_ped_Constraint *);
 
 extern PyTypeObject _ped_Constraint_Type_obj;
 
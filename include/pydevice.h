@@ -43,8 +43,6 @@ void _ped_CHSGeometry_dealloc(_ped_CHSGeometry *);
 int _ped_CHSGeometry_compare(_ped_CHSGeometry *, PyObject *);
 PyObject *_ped_CHSGeometry_richcompare(_ped_CHSGeometry *, PyObject *, int);
 PyObject *_ped_CHSGeometry_str(_ped_CHSGeometry *);
-int _ped_CHSGeometry_traverse(_ped_CHSGeometry *, visitproc, void *);
-int _ped_CHSGeometry_clear(_ped_CHSGeometry *);
 PyObject *_ped_CHSGeometry_get(_ped_CHSGeometry *, void *);
 
 extern PyTypeObject _ped_CHSGeometry_Type_obj;
@@ -66,19 +64,22 @@ typedef struct {
     int external_mode;
     int dirty;
     int boot_dirty;
-    PyObject *hw_geom;            /* a _ped.CHSGeometry */
-    PyObject *bios_geom;          /* a _ped.CHSGeometry */
+    PedCHSGeometry hw_geom;       /* a _ped.CHSGeometry on access */
+    PedCHSGeometry bios_geom;     /* a _ped.CHSGeometry on access */
     short host;
     short did;
+    int direct_io;                /* read() and write() bypass the page cache */
+    int direct_fd;                /* descriptor for direct_io, or -1 */
+    int direct_odirect;           /* direct_fd was opened with O_DIRECT */
+    int direct_busy;              /* direct I/O calls using direct_fd */
 } _ped_Device;
 
 void _ped_Device_dealloc(_ped_Device *);
 int _ped_Device_compare(_ped_Device *, PyObject *);
 PyObject *_ped_Device_richcompare(_ped_Device *, PyObject *, int);
 PyObject *_ped_Device_str(_ped_Device *);
-int _ped_Device_traverse(_ped_Device *, visitproc, void *);
-int _ped_Device_clear(_ped_Device *);
 PyObject *_ped_Device_get(_ped_Device *, void *);
+int _ped_Device_set(_ped_Device *, PyObject *, void *);
 
 extern PyTypeObject _ped_Device_Type_obj;
 
@@ -105,6 +106,10 @@ PyObject *py_ped_device_get_minimal_aligned_constraint(PyObject *, PyObject *);
 PyObject *py_ped_device_get_optimal_aligned_constraint(PyObject *, PyObject *);
 PyObject *py_ped_device_get_minimum_alignment(PyObject *, PyObject *);
 PyObject *py_ped_device_get_optimum_alignment(PyObject *, PyObject *);
+PyObject *py_ped_device_find_signatures(PyObject *, PyObject *);
+PyObject *py_ped_device_zero_range(PyObject *, PyObject *);
+PyObject *py_ped_device_discard_range(PyObject *, PyObject *);
+PyObject *py_ped_device_mmap_view(PyObject *, PyObject *);
 PyObject *py_ped_unit_get_size(PyObject *, PyObject *);
 PyObject *py_ped_unit_format_custom_byte(PyObject *, PyObject *);
 PyObject *py_ped_unit_format_byte(PyObject *, PyObject *);
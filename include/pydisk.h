@@ -122,6 +122,8 @@ PyObject *py_ped_disk_max_partition_start_sector(PyObject *, PyObject *);
 PyObject *py_ped_disk_set_flag(PyObject *, PyObject *);
 PyObject *py_ped_disk_get_flag(PyObject *, PyObject *);
 PyObject *py_ped_disk_is_flag_available(PyObject *, PyObject *);
+PyObject *py_ped_disk_get_flags(PyObject *, PyObject *);
+PyObject *py_ped_disk_set_flags(PyObject *, PyObject *);
 PyObject *py_ped_disk_flag_get_name(PyObject *, PyObject *);
 PyObject *py_ped_disk_flag_get_by_name(PyObject *, PyObject *);
 PyObject *py_ped_disk_flag_next(PyObject *, PyObject *);
@@ -130,6 +132,8 @@ PyObject *py_ped_partition_is_active(_ped_Partition *, PyObject *);
 PyObject *py_ped_partition_set_flag(_ped_Partition *, PyObject *);
 PyObject *py_ped_partition_get_flag(_ped_Partition *, PyObject *);
 PyObject *py_ped_partition_is_flag_available(_ped_Partition *, PyObject *);
+PyObject *py_ped_partition_get_flags(_ped_Partition *, PyObject *);
+PyObject *py_ped_partition_set_flags(_ped_Partition *, PyObject *);
 PyObject *py_ped_partition_set_system(_ped_Partition *, PyObject *);
 PyObject *py_ped_partition_set_name(_ped_Partition *, PyObject *);
 PyObject *py_ped_partition_get_name(_ped_Partition *, PyObject *);
@@ -152,6 +156,8 @@ PyObject *py_ped_disk_next_partition(PyObject *, PyObject *);
 PyObject *py_ped_disk_get_partition(PyObject *, PyObject *);
 PyObject *py_ped_disk_get_partition_by_sector(PyObject *, PyObject *);
 PyObject *py_ped_disk_extended_partition(PyObject *, PyObject *);
+PyObject *py_ped_disk_audit_alignment(PyObject *, PyObject *);
+PyObject *py_ped_disk_probe_filesystems(PyObject *, PyObject *, PyObject *);
 PyObject *py_ped_disk_new_fresh(PyObject *, PyObject *);
 PyObject *py_ped_disk_new(PyObject *, PyObject *);
 
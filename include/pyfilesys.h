@@ -38,6 +38,48 @@ PyObject *py_ped_file_system_type_get(PyObject *, PyObject *);
 PyObject *py_ped_file_system_type_get_next(PyObject *, PyObject *);
 PyObject *py_ped_file_system_probe_specific(PyObject *, PyObject *);
 PyObject *py_ped_file_system_probe(PyObject *, PyObject *);
+PyObject *py_ped_file_system_probe_coalesce(PyObject *, PyObject *);
+PyObject *py_ped_file_system_probe_cache(PyObject *, PyObject *);
+PyObject *py_ped_file_system_probe_cache_clear(PyObject *, PyObject *);
+PyObject *py_ped_file_system_probe_cache_info(PyObject *, PyObject *);
+PyObject *py_ped_file_system_probe_cache_save(PyObject *, PyObject *);
+PyObject *py_ped_file_system_probe_cache_load(PyObject *, PyObject *);
+
+PedFileSystemType *file_system_probe_cached(PedGeometry *);
+void file_system_probe_cache_flush(void);
+
+/* Native signature probing, see pyfilesys.c.  None of these touch libparted
+ * or the Python API, so they may be called with the GIL released. */
+#define FS_PROBE_MAX_WORKERS 64
+#define FS_SIGNATURE_MAX_BLOCK 4096
+
+typedef const char *(*fs_signature_check)(const unsigned char *, const char *);
+
+typedef struct {
+    long long offset;           /* start of the block holding the magic */
+    size_t size;                /* bytes of that block to read */
+    size_t magic_at;            /* position of the magic in the block */
+    const char *magic;
+    size_t magic_len;
+    const char *name;           /* libparted filesystem type name */
+    fs_signature_check check;   /* further validation, or NULL */
+    int confirm;                /* libparted's probe looks further and decides */
+} fs_signature;
+
+/* Terminated by an entry with a NULL magic. */
+extern const fs_signature fs_signatures[];
+
+typedef struct {
+    long long offset;           /* start of the region in bytes */
+    long long length;           /* length of the region in bytes */
+    const char *name;           /* filesystem type name, or NULL */
+    int confirm;                /* name still needs libparted's probe */
+    int error;                  /* errno of a failed read, or 0 */
+} fs_probe_job;
+
+void fs_signature_probe(int, fs_probe_job *, unsigned char *, size_t);
+void fs_probe_jobs(const char *, fs_probe_job *, int, int, size_t);
+size_t file_system_probe_coalesce_size(void);
 
 /* _ped.FileSystemType type is the Python equivalent of PedFileSystemType
  * in libparted */
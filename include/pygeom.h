@@ -46,6 +46,9 @@ PyObject *py_ped_geometry_sync_fast(PyObject *, PyObject *);
 PyObject *py_ped_geometry_write(PyObject *, PyObject *);
 PyObject *py_ped_geometry_check(PyObject *, PyObject *);
 PyObject *py_ped_geometry_map(PyObject *, PyObject *);
+PyObject *py_ped_geometry_copy_to(PyObject *, PyObject *);
+PyObject *py_ped_geometry_diff(PyObject *, PyObject *);
+PyObject *py_ped_geometry_digest(PyObject *, PyObject *);
 
 /* _ped.Geometry type is the Python equivalent of PedGeometry in libparted */
 typedef struct {
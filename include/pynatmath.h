@@ -38,6 +38,12 @@ PyObject *py_ped_alignment_align_down(PyObject *, PyObject *);
 PyObject *py_ped_alignment_align_nearest(PyObject *, PyObject *);
 PyObject *py_ped_alignment_is_aligned(PyObject *, PyObject *);
 
+/* batch variants over buffers of sectors */
+PyObject *py_ped_alignment_align_up_many(PyObject *, PyObject *);
+PyObject *py_ped_alignment_align_down_many(PyObject *, PyObject *);
+PyObject *py_ped_alignment_align_nearest_many(PyObject *, PyObject *);
+PyObject *py_ped_alignment_is_aligned_many(PyObject *, PyObject *);
+
 /* _ped.Alignment type is the Python equivalent of PedAlignment in libparted */
 typedef struct {
     PyObject_HEAD
@@ -51,8 +57,6 @@ void _ped_Alignment_dealloc(_ped_Alignment *);
 int _ped_Alignment_compare(_ped_Alignment *, PyObject *);
 PyObject *_ped_Alignment_richcompare(_ped_Alignment *, PyObject *, int);
 PyObject *_ped_Alignment_str(_ped_Alignment *);
-int _ped_Alignment_traverse(_ped_Alignment *, visitproc, void *);
-int _ped_Alignment_clear(_ped_Alignment *);
 int _ped_Alignment_init(_ped_Alignment *, PyObject *, PyObject *);
 PyObject *_ped_Alignment_get(_ped_Alignment *, void *);
 int _ped_Alignment_set(_ped_Alignment *, PyObject *, void *);
@@ -0,0 +1,58 @@
+/*
+ * pystats.h
+ * pyparted declarations for the call instrumentation and I/O trace in
+ * pystats.c
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ *
+ * This copyrighted material is made available to anyone wishing to use,
+ * modify, copy, or redistribute it subject to the terms and conditions of
+ * the GNU General Public License v.2, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY expressed or implied, including the implied warranties of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.  You should have received a copy of the
+ * GNU General Public License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.  Any Red Hat trademarks that are incorporated in the
+ * source code or documentation are not subject to the GNU General Public
+ * License and may only be used or replicated with the express permission of
+ * Red Hat, Inc.
+ */
+
+#ifndef PYSTATS_H_INCLUDED
+#define PYSTATS_H_INCLUDED
+
+#include <Python.h>
+
+/* Latency histogram buckets: bucket i counts calls that took less than
+ * 2**i microseconds, the last one everything slower. */
+#define STATS_BUCKETS 24
+
+/* Bytes moved by _ped, whether through libparted or rawio.c.  libparted I/O
+ * is only counted while instrumentation is on.  Updated from threads that
+ * do not hold the GIL, hence the atomic adds. */
+extern unsigned long long ped_stats_bytes_read;
+extern unsigned long long ped_stats_bytes_written;
+
+static inline void ped_stats_count_io(int writing, unsigned long long bytes) {
+    __atomic_fetch_add(writing ? &ped_stats_bytes_written : &ped_stats_bytes_read,
+                       bytes, __ATOMIC_RELAXED);
+}
+
+PyObject *_ped_object_alloc(PyTypeObject *, Py_ssize_t);
+void _ped_object_free(void *);
+
+PyObject *py_ped_stats_enable(PyObject *, PyObject *);
+PyObject *py_ped_stats(PyObject *, PyObject *);
+PyObject *py_ped_stats_reset(PyObject *, PyObject *);
+PyObject *py_ped_trace_enable(PyObject *, PyObject *);
+PyObject *py_ped_trace_drain(PyObject *, PyObject *);
+PyObject *py_ped_trace_info(PyObject *, PyObject *);
+PyObject *py_ped_live_objects(PyObject *, PyObject *);
+PyObject *py_ped_native_memory(PyObject *, PyObject *);
+
+#endif /* PYSTATS_H_INCLUDED */
+
+/* vim:tw=78:ts=4:et:sw=4
+ */
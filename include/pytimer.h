@@ -64,6 +64,12 @@ int _ped_Timer_set(_ped_Timer *, PyObject *, void *);
 
 extern PyTypeObject _ped_Timer_Type_obj;
 
+/* Progress reporting for native bulk operations, see pytimer.c */
+int progress_timer_check(PyObject *);
+PedTimer *progress_timer_new(PyObject *, const char *);
+int progress_timer_update(PedTimer *, float);
+void progress_timer_destroy(PedTimer *);
+
 #endif /* PYTIMER_H_INCLUDED */
 
 /* vim:tw=78:ts=4:et:sw=4
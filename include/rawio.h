@@ -0,0 +1,109 @@
+/*
+ * rawio.h
+ * Plain file descriptor I/O for the native code that runs without the GIL
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ *
+ * This copyrighted material is made available to anyone wishing to use,
+ * modify, copy, or redistribute it subject to the terms and conditions of
+ * the GNU General Public License v.2, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY expressed or implied, including the implied warranties of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.  You should have received a copy of the
+ * GNU General Public License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.  Any Red Hat trademarks that are incorporated in the
+ * source code or documentation are not subject to the GNU General Public
+ * License and may only be used or replicated with the express permission of
+ * Red Hat, Inc.
+ */
+
+#ifndef RAWIO_H_INCLUDED
+#define RAWIO_H_INCLUDED
+
+#include <pthread.h>
+#include <sys/types.h>
+
+/* Buffers for bulk I/O are aligned for O_DIRECT on any common device. */
+#define RAWIO_ALIGN         4096
+#define RAWIO_ZERO_BUF      (1024 * 1024)
+
+#define RAWIO_ZERO          1
+#define RAWIO_DISCARD       2
+
+/* How rawio_clear() clears a range, from the cheapest up. */
+#define RAWIO_CLEAR_NATIVE  0
+#define RAWIO_CLEAR_PUNCH   1
+#define RAWIO_CLEAR_WRITE   2
+
+#define RAWIO_MAX_THREADS   16
+
+/* Aligned buffers kept for reuse by rawio_buf_get() */
+#define RAWIO_POOL_SLOTS    8
+#define RAWIO_POOL_MAX      (16 * 1024 * 1024)
+
+#define RAWIO_COPY_SPARSE   0x1     /* punch holes for chunks of zeros */
+#define RAWIO_COPY_RANGE    0x2     /* try copy_file_range(2) first */
+
+/* A copy shared by the worker threads of rawio_copy_work() */
+typedef struct {
+    int src_fd;
+    long long src_offset;
+    int dst_fd;
+    long long dst_offset;
+    long long size;             /* bytes to copy */
+    size_t chunk;               /* bytes per read and write */
+
+    pthread_mutex_t lock;       /* protects the members below */
+    int flags;                  /* RAWIO_COPY_* */
+    long long next;             /* offset of the next chunk to hand out */
+    long long done;             /* bytes copied so far */
+    int error;                  /* first errno value seen, or 0 */
+    int cancel;
+} rawio_copy_job;
+
+/* A comparison shared by the worker threads of rawio_diff_work() */
+typedef struct {
+    int a_fd;
+    long long a_offset;
+    int b_fd;
+    long long b_offset;
+    long long size;             /* bytes to compare */
+    size_t chunk;               /* bytes per comparison */
+    unsigned char *differs;     /* set to 1 for each chunk that differs */
+
+    pthread_mutex_t lock;       /* protects the members below */
+    long long next;             /* offset of the next chunk to hand out */
+    long long done;             /* bytes compared so far */
+    int error;                  /* first errno value seen, or 0 */
+    int cancel;
+} rawio_diff_job;
+
+ssize_t rawio_pread(int, void *, size_t, long long);
+int rawio_pwrite(int, const void *, size_t, long long);
+int rawio_clear(int, int, long long, long long, int *);
+int rawio_is_zero(const unsigned char *, size_t);
+
+int rawio_open_direct(const char *, int, int *);
+int rawio_drop_cache(int, long long, long long, int);
+void *rawio_buf_get(size_t *, size_t);
+void rawio_buf_put(void *, size_t, size_t);
+
+void rawio_copy_init(rawio_copy_job *, int, long long, int, long long,
+                     long long, size_t);
+void rawio_copy_destroy(rawio_copy_job *);
+int rawio_copy_work(rawio_copy_job *, unsigned char *, int);
+int rawio_copy_start(rawio_copy_job *, pthread_t *, int);
+void rawio_copy_join(pthread_t *, int);
+
+void rawio_diff_init(rawio_diff_job *, int, long long, int, long long,
+                     long long, size_t, unsigned char *);
+void rawio_diff_destroy(rawio_diff_job *);
+int rawio_diff_work(rawio_diff_job *, unsigned char *, int);
+int rawio_diff_start(rawio_diff_job *, pthread_t *, int);
+
+#endif /* RAWIO_H_INCLUDED */
+
+/* vim:tw=78:ts=4:et:sw=4
+ */
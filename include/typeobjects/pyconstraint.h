@@ -31,14 +31,6 @@
 
 /* _ped.Constraint type object */
 static PyMemberDef _ped_Constraint_members[] = {
-    {"start_align", T_OBJECT, offsetof(_ped_Constraint, start_align), 0,
-                    "The _ped.Alignment describing the starting alignment constraints of the partition."},
-    {"end_align", T_OBJECT, offsetof(_ped_Constraint, end_align), 0,
-                  "The _ped.Alignment describing the ending alignment constraints of the partition."},
-    {"start_range", T_OBJECT, offsetof(_ped_Constraint, start_range), 0,
-                    "The _ped.Geometry describing the minimum size constraints of the partition."},
-    {"end_range", T_OBJECT, offsetof(_ped_Constraint, end_range), 0,
-                  "The _ped.Geometry describing the maximum size constraints of the partition."},
     {NULL}
 };
 
@@ -57,6 +49,18 @@ static PyMethodDef _ped_Constraint_methods[] = {
 };
 
 static PyGetSetDef _ped_Constraint_getset[] = {
+    {"start_align", (getter) _ped_Constraint_get,
+                    (setter) _ped_Constraint_set,
+                    "The _ped.Alignment describing the starting alignment constraints of the partition.", "start_align"},
+    {"end_align", (getter) _ped_Constraint_get,
+                  (setter) _ped_Constraint_set,
+                  "The _ped.Alignment describing the ending alignment constraints of the partition.", "end_align"},
+    {"start_range", (getter) _ped_Constraint_get,
+                    (setter) _ped_Constraint_set,
+                    "The _ped.Geometry describing the minimum size constraints of the partition.", "start_range"},
+    {"end_range", (getter) _ped_Constraint_get,
+                  (setter) _ped_Constraint_set,
+                  "The _ped.Geometry describing the maximum size constraints of the partition.", "end_range"},
     {"min_size", (getter) _ped_Constraint_get,
                  (setter) _ped_Constraint_set,
                  "The mimimum size in _ped.Sectors of the partition.", "min_size"},
@@ -101,9 +105,9 @@ PyTypeObject _ped_Constraint_Type_obj = {
  /* .tp_descr_set = XXX */
  /* .tp_dictoffset = XXX */
     .tp_init = (initproc) _ped_Constraint_init,
-    .tp_alloc = PyType_GenericAlloc,
+    .tp_alloc = _ped_object_alloc,
     .tp_new = PyType_GenericNew,
- /* .tp_free = XXX */
+    .tp_free = _ped_object_free,
  /* .tp_is_gc = XXX */
     .tp_bases = NULL,
  /* .tp_del = XXX */
@@ -69,10 +69,8 @@ PyTypeObject _ped_CHSGeometry_Type_obj = {
     .tp_getattro = PyObject_GenericGetAttr,
     .tp_setattro = PyObject_GenericSetAttr,
  /* .tp_as_buffer = XXX */
-    .tp_flags = TP_FLAGS,
+    .tp_flags = TP_FLAGS_LEAF,
     .tp_doc = _ped_CHSGeometry_doc,
-    .tp_traverse = (traverseproc) _ped_CHSGeometry_traverse,
-    .tp_clear = (inquiry) _ped_CHSGeometry_clear,
     .tp_richcompare = (richcmpfunc) _ped_CHSGeometry_richcompare,
  /* .tp_weaklistoffset = XXX */
  /* .tp_iter = XXX */
@@ -86,23 +84,15 @@ PyTypeObject _ped_CHSGeometry_Type_obj = {
  /* .tp_descr_set = XXX */
  /* .tp_dictoffset = XXX */
     .tp_init = NULL,
-    .tp_alloc = PyType_GenericAlloc,
+    .tp_alloc = _ped_object_alloc,
     .tp_new = NULL,
- /* .tp_free = XXX */
+    .tp_free = _ped_object_free,
  /* .tp_is_gc = XXX */
     .tp_bases = NULL,
  /* .tp_del = XXX */
 };
 
 /* _ped.Device type object */
-static PyMemberDef _ped_Device_members[] = {
-    {"hw_geom", T_OBJECT, offsetof(_ped_Device, hw_geom), READONLY,
-                "The CHSGeometry of the Device as reported by the hardware."},
-    {"bios_geom", T_OBJECT, offsetof(_ped_Device, bios_geom), READONLY,
-                  "The CHSGeometry of the Device as reported by the BIOS."},
-    {NULL}
-};
-
 static PyMethodDef _ped_Device_methods[] = {
     /*
      * This is a unique function as it's in pydisk.c, but is really
@@ -150,6 +140,14 @@ static PyMethodDef _ped_Device_methods[] = {
     {"get_optimum_alignment",
                   (PyCFunction) py_ped_device_get_optimum_alignment,
                   METH_NOARGS, device_get_optimum_alignment_doc},
+    {"find_signatures", (PyCFunction) py_ped_device_find_signatures,
+                        METH_VARARGS, device_find_signatures_doc},
+    {"zero_range", (PyCFunction) py_ped_device_zero_range, METH_VARARGS,
+                   device_zero_range_doc},
+    {"discard_range", (PyCFunction) py_ped_device_discard_range,
+                      METH_VARARGS, device_discard_range_doc},
+    {"mmap_view", (PyCFunction) py_ped_device_mmap_view, METH_VARARGS,
+                  device_mmap_view_doc},
 
     /*
      * These functions are in pydisk.c, but they work best as
@@ -209,6 +207,15 @@ static PyGetSetDef _ped_Device_getset[] = {
              "Any SCSI host ID associated with self.", "host"},
     {"did", (getter) _ped_Device_get, NULL,
             "Any SCSI device ID associated with self.", "did"},
+    {"hw_geom", (getter) _ped_Device_get, NULL,
+                "The CHSGeometry of the Device as reported by the hardware.",
+                "hw_geom"},
+    {"bios_geom", (getter) _ped_Device_get, NULL,
+                  "The CHSGeometry of the Device as reported by the BIOS.",
+                  "bios_geom"},
+    {"direct_io", (getter) _ped_Device_get, (setter) _ped_Device_set,
+                  "Do read() and write() bypass the page cache?",
+                  "direct_io"},
     {NULL}  /* Sentinel */
 };
 
@@ -224,22 +231,20 @@ PyTypeObject _ped_Device_Type_obj = {
  /* .tp_as_number = XXX */
  /* .tp_as_sequence = XXX */
  /* .tp_as_mapping = XXX */
-    .tp_hash = PyObject_HashNotImplemented,
+    .tp_hash = (hashfunc) _ped_Device_hash,
     .tp_call = NULL,
     .tp_str = (reprfunc) _ped_Device_str,
     .tp_getattro = PyObject_GenericGetAttr,
     .tp_setattro = PyObject_GenericSetAttr,
  /* .tp_as_buffer = XXX */
-    .tp_flags = TP_FLAGS,
+    .tp_flags = TP_FLAGS_LEAF,
     .tp_doc = _ped_Device_doc,
-    .tp_traverse = (traverseproc) _ped_Device_traverse,
-    .tp_clear = (inquiry) _ped_Device_clear,
     .tp_richcompare = (richcmpfunc) _ped_Device_richcompare,
  /* .tp_weaklistoffset = XXX */
  /* .tp_iter = XXX */
  /* .tp_iternext = XXX */
     .tp_methods = _ped_Device_methods,
-    .tp_members = _ped_Device_members,
+ /* .tp_members = XXX */
     .tp_getset = _ped_Device_getset,
     .tp_base = NULL,
     .tp_dict = NULL,
@@ -247,9 +252,9 @@ PyTypeObject _ped_Device_Type_obj = {
  /* .tp_descr_set = XXX */
  /* .tp_dictoffset = XXX */
     .tp_init = NULL,
-    .tp_alloc = PyType_GenericAlloc,
+    .tp_alloc = _ped_object_alloc,
     .tp_new = NULL,
- /* .tp_free = XXX */
+    .tp_free = _ped_object_free,
  /* .tp_is_gc = XXX */
     .tp_bases = NULL,
  /* .tp_del = XXX */
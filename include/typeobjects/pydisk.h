@@ -51,6 +51,10 @@ static PyMethodDef _ped_Partition_methods[] = {
                  partition_get_flag_doc},
     {"is_flag_available", (PyCFunction) py_ped_partition_is_flag_available,
                           METH_VARARGS, partition_is_flag_available_doc},
+    {"get_flags", (PyCFunction) py_ped_partition_get_flags, METH_NOARGS,
+                  partition_get_flags_doc},
+    {"set_flags", (PyCFunction) py_ped_partition_set_flags, METH_VARARGS,
+                  partition_set_flags_doc},
     {"set_system", (PyCFunction) py_ped_partition_set_system,
                    METH_VARARGS, partition_set_system_doc},
     {"set_name", (PyCFunction) py_ped_partition_set_name, METH_VARARGS,
@@ -87,7 +91,7 @@ PyTypeObject _ped_Partition_Type_obj = {
  /* .tp_as_number = XXX */
  /* .tp_as_sequence = XXX */
  /* .tp_as_mapping = XXX */
-    .tp_hash = PyObject_HashNotImplemented,
+    .tp_hash = (hashfunc) _ped_Partition_hash,
     .tp_call = NULL,
     .tp_str = (reprfunc) _ped_Partition_str,
     .tp_getattro = PyObject_GenericGetAttr,
@@ -110,9 +114,9 @@ PyTypeObject _ped_Partition_Type_obj = {
  /* .tp_descr_set = XXX */
  /* .tp_dictoffset = XXX */
     .tp_init = (initproc) _ped_Partition_init,
-    .tp_alloc = PyType_GenericAlloc,
+    .tp_alloc = _ped_object_alloc,
     .tp_new = PyType_GenericNew,
- /* .tp_free = XXX */
+    .tp_free = _ped_object_free,
  /* .tp_is_gc = XXX */
     .tp_bases = NULL,
  /* .tp_del = XXX */
@@ -176,6 +180,10 @@ static PyMethodDef _ped_Disk_methods[] = {
                  disk_get_flag_doc},
     {"is_flag_available", (PyCFunction) py_ped_disk_is_flag_available,
                           METH_VARARGS, disk_is_flag_available_doc},
+    {"get_flags", (PyCFunction) py_ped_disk_get_flags, METH_NOARGS,
+                  disk_get_flags_doc},
+    {"set_flags", (PyCFunction) py_ped_disk_set_flags, METH_VARARGS,
+                  disk_set_flags_doc},
     {"add_partition", (PyCFunction) py_ped_disk_add_partition,
                       METH_VARARGS, disk_add_partition_doc},
     {"remove_partition", (PyCFunction) py_ped_disk_remove_partition,
@@ -205,6 +213,11 @@ static PyMethodDef _ped_Disk_methods[] = {
                                 METH_VARARGS, disk_get_partition_by_sector_doc},
     {"extended_partition", (PyCFunction) py_ped_disk_extended_partition,
                            METH_VARARGS, disk_extended_partition_doc},
+    {"audit_alignment", (PyCFunction) py_ped_disk_audit_alignment,
+                        METH_VARARGS, disk_audit_alignment_doc},
+    {"probe_filesystems", (PyCFunction) py_ped_disk_probe_filesystems,
+                          METH_VARARGS | METH_KEYWORDS,
+                          disk_probe_filesystems_doc},
     {NULL}
 };
 
@@ -248,9 +261,9 @@ PyTypeObject _ped_Disk_Type_obj = {
  /* .tp_descr_set = XXX */
  /* .tp_dictoffset = XXX */
     .tp_init = (initproc) _ped_Disk_init,
-    .tp_alloc = PyType_GenericAlloc,
+    .tp_alloc = _ped_object_alloc,
     .tp_new = PyType_GenericNew,
- /* .tp_free = XXX */
+    .tp_free = _ped_object_free,
  /* .tp_is_gc = XXX */
     .tp_bases = NULL,
  /* .tp_del = XXX */
@@ -312,9 +325,9 @@ PyTypeObject _ped_DiskType_Type_obj = {
  /* .tp_descr_set = XXX */
  /* .tp_dictoffset = XXX */
     .tp_init = NULL,
-    .tp_alloc = PyType_GenericAlloc,
+    .tp_alloc = _ped_object_alloc,
     .tp_new = NULL,
- /* .tp_free = XXX */
+    .tp_free = _ped_object_free,
  /* .tp_is_gc = XXX */
     .tp_bases = NULL,
  /* .tp_del = XXX */
@@ -79,9 +79,9 @@ PyTypeObject _ped_FileSystemType_Type_obj = {
  /* .tp_descr_set = XXX */
  /* .tp_dictoffset = XXX */
     .tp_init = NULL,
-    .tp_alloc = PyType_GenericAlloc,
+    .tp_alloc = _ped_object_alloc,
     .tp_new = NULL,
- /* .tp_free = XXX */
+    .tp_free = _ped_object_free,
  /* .tp_is_gc = XXX */
     .tp_bases = NULL,
  /* .tp_del = XXX */
@@ -131,9 +131,9 @@ PyTypeObject _ped_FileSystem_Type_obj = {
  /* .tp_descr_set = XXX */
  /* .tp_dictoffset = XXX */
     .tp_init = (initproc) _ped_FileSystem_init,
-    .tp_alloc = PyType_GenericAlloc,
+    .tp_alloc = _ped_object_alloc,
     .tp_new = PyType_GenericNew,
- /* .tp_free = XXX */
+    .tp_free = _ped_object_free,
  /* .tp_is_gc = XXX */
     .tp_bases = NULL,
  /* .tp_del = XXX */
@@ -67,6 +67,12 @@ static PyMethodDef _ped_Geometry_methods[] = {
               geometry_check_doc},
     {"map", (PyCFunction) py_ped_geometry_map, METH_VARARGS,
             geometry_map_doc},
+    {"copy_to", (PyCFunction) py_ped_geometry_copy_to, METH_VARARGS,
+                geometry_copy_to_doc},
+    {"diff", (PyCFunction) py_ped_geometry_diff, METH_VARARGS,
+             geometry_diff_doc},
+    {"digest", (PyCFunction) py_ped_geometry_digest, METH_VARARGS,
+               geometry_digest_doc},
     {NULL}
 };
 
@@ -96,7 +102,7 @@ PyTypeObject _ped_Geometry_Type_obj = {
  /* .tp_as_number = XXX */
  /* .tp_as_sequence = XXX */
  /* .tp_as_mapping = XXX */
-    .tp_hash = PyObject_HashNotImplemented,
+    .tp_hash = (hashfunc) _ped_Geometry_hash,
     .tp_call = NULL,
     .tp_str = (reprfunc) _ped_Geometry_str,
     .tp_getattro = PyObject_GenericGetAttr,
@@ -119,9 +125,9 @@ PyTypeObject _ped_Geometry_Type_obj = {
  /* .tp_descr_set = XXX */
  /* .tp_dictoffset = XXX */
     .tp_init = (initproc) _ped_Geometry_init,
-    .tp_alloc = PyType_GenericAlloc,
+    .tp_alloc = _ped_object_alloc,
     .tp_new = PyType_GenericNew,
- /* .tp_free = XXX */
+    .tp_free = _ped_object_free,
  /* .tp_is_gc = XXX */
     .tp_bases = NULL,
  /* .tp_del = XXX */
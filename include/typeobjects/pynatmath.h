@@ -47,6 +47,14 @@ static PyMethodDef _ped_Alignment_methods[] = {
                       METH_VARARGS, alignment_align_nearest_doc},
     {"is_aligned", (PyCFunction) py_ped_alignment_is_aligned,
                    METH_VARARGS, alignment_is_aligned_doc},
+    {"align_up_many", (PyCFunction) py_ped_alignment_align_up_many,
+                      METH_VARARGS, alignment_align_up_many_doc},
+    {"align_down_many", (PyCFunction) py_ped_alignment_align_down_many,
+                        METH_VARARGS, alignment_align_down_many_doc},
+    {"align_nearest_many", (PyCFunction) py_ped_alignment_align_nearest_many,
+                           METH_VARARGS, alignment_align_nearest_many_doc},
+    {"is_aligned_many", (PyCFunction) py_ped_alignment_is_aligned_many,
+                        METH_VARARGS, alignment_is_aligned_many_doc},
     {NULL}
 };
 
@@ -78,10 +86,8 @@ PyTypeObject _ped_Alignment_Type_obj = {
     .tp_getattro = PyObject_GenericGetAttr,
     .tp_setattro = PyObject_GenericSetAttr,
  /* .tp_as_buffer = XXX */
-    .tp_flags = TP_FLAGS,
+    .tp_flags = TP_FLAGS_LEAF,
     .tp_doc = _ped_Alignment_doc,
-    .tp_traverse = (traverseproc) _ped_Alignment_traverse,
-    .tp_clear = (inquiry) _ped_Alignment_clear,
     .tp_richcompare = (richcmpfunc) _ped_Alignment_richcompare,
  /* .tp_weaklistoffset = XXX */
  /* .tp_iter = XXX */
@@ -95,9 +101,9 @@ PyTypeObject _ped_Alignment_Type_obj = {
  /* .tp_descr_set = XXX */
  /* .tp_dictoffset = XXX */
     .tp_init = (initproc) _ped_Alignment_init,
-    .tp_alloc = PyType_GenericAlloc,
+    .tp_alloc = _ped_object_alloc,
     .tp_new = PyType_GenericNew,
- /* .tp_free = XXX */
+    .tp_free = _ped_object_free,
  /* .tp_is_gc = XXX */
     .tp_bases = NULL,
  /* .tp_del = XXX */
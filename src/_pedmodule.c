@@ -39,6 +39,7 @@
 #include "pyfilesys.h"
 #include "pygeom.h"
 #include "pynatmath.h"
+#include "pystats.h"
 #include "pytimer.h"
 #include "pyunit.h"
 
@@ -88,6 +89,25 @@ PyDoc_STRVAR(constraint_exact_doc,
 "constraint_exact(Geometry) -> Constraint\n\n"
 "Return a Constraint that only the given Geometry will satisfy.");
 
+PyDoc_STRVAR(constraint_solver_cache_doc,
+"constraint_solver_cache([enable]) -> boolean\n\n"
+"Turn the Constraint solver cache on or off and return its previous state.\n"
+"When on, Constraint.solve_max() and Constraint.solve_nearest() remember\n"
+"their results keyed on the constraint parameters, the Device's sector size\n"
+"and length, and the target Geometry, so repeated planning on identical\n"
+"disks skips libparted even when they are at different paths.\n"
+"Turning the cache off also empties it.  With no argument, just return the\n"
+"current state.");
+
+PyDoc_STRVAR(constraint_solver_cache_clear_doc,
+"constraint_solver_cache_clear()\n\n"
+"Empty the Constraint solver cache and reset its hit and miss counters.");
+
+PyDoc_STRVAR(constraint_solver_cache_info_doc,
+"constraint_solver_cache_info() -> dict\n\n"
+"Return a dict describing the Constraint solver cache with the keys\n"
+"enabled, hits, misses, size, and max_size.");
+
 PyDoc_STRVAR(device_get_doc,
 "device_get(string) -> Device\n\n"
 "Return the Device corresponding to the given path.  Typically, path will\n"
@@ -112,6 +132,49 @@ PyDoc_STRVAR(file_system_probe_doc,
 "situations, such as when one file system was not completely erased\n"
 "before a new file system was created on top of it.");
 
+PyDoc_STRVAR(file_system_probe_coalesce_doc,
+"file_system_probe_coalesce([kib]) -> integer\n\n"
+"Set how many KiB at the start of each partition Disk.probe_filesystems()\n"
+"reads in one go, and return the previous setting.  All the superblock\n"
+"signatures within that window are then checked from memory, so with 68,\n"
+"which covers every signature pyparted knows natively, each partition\n"
+"recognized natively costs a single read.  That pays off on high-latency\n"
+"devices.  FAT and HFS+ volumes and unrecognized partitions are read again\n"
+"by libparted's probes.  0, the default, reads each signature block\n"
+"separately.  With no argument, just return the current setting.");
+
+PyDoc_STRVAR(file_system_probe_cache_doc,
+"file_system_probe_cache([enable]) -> boolean\n\n"
+"Turn the filesystem probe cache on or off and return its previous state.\n"
+"When on, file_system_probe() and Disk.probe_filesystems() remember what\n"
+"they found keyed on the device identity, the region, and a hash of its\n"
+"first 68 KiB, so probing an unchanged partition again skips libparted.\n"
+"A change that only touches data past that, such as a backup header near\n"
+"the end of the partition, is not noticed; clear the cache after one.\n"
+"Turning the cache off also empties it.  With no argument, just return the\n"
+"current state.");
+
+PyDoc_STRVAR(file_system_probe_cache_clear_doc,
+"file_system_probe_cache_clear()\n\n"
+"Empty the filesystem probe cache and reset its hit and miss counters.");
+
+PyDoc_STRVAR(file_system_probe_cache_info_doc,
+"file_system_probe_cache_info() -> dict\n\n"
+"Return a dict describing the filesystem probe cache with the keys\n"
+"enabled, hits, misses, size, and max_size.");
+
+PyDoc_STRVAR(file_system_probe_cache_save_doc,
+"file_system_probe_cache_save(path) -> integer\n\n"
+"Write the filesystem probe cache to the file at path, replacing it\n"
+"atomically, and return the number of entries written.");
+
+PyDoc_STRVAR(file_system_probe_cache_load_doc,
+"file_system_probe_cache_load(path) -> integer\n\n"
+"Merge the entries saved by file_system_probe_cache_save() into the\n"
+"filesystem probe cache and return how many were loaded.  The cache must\n"
+"still be turned on with file_system_probe_cache() to be used.  Raises\n"
+"ValueError if path is not a probe cache file from this build.");
+
 PyDoc_STRVAR(file_system_probe_specific_doc,
 "file_system_probe_specific(FileSystemType, Geometry) -> Geometry\n\n"
 "Attempt to find a file system and return the region it occupies.");
@@ -200,6 +263,62 @@ PyDoc_STRVAR(unit_get_by_name_doc,
 "Returns a Unit given its textual representation.  Returns one of the\n"
 "UNIT_* constants.");
 
+PyDoc_STRVAR(stats_enable_doc,
+"stats_enable([enable]) -> boolean\n\n"
+"Turn per-call instrumentation of every _ped function and method on or off\n"
+"and return its previous state.  While it is on, each call is timed and the\n"
+"bytes read and written and the _ped objects created during it are counted.\n"
+"Turning it off restores the original functions, so it costs nothing when\n"
+"not in use.  Functions bound to other names before it was turned on, such\n"
+"as by 'from _ped import ...', are not instrumented.  With no argument, just\n"
+"return the current state.");
+
+PyDoc_STRVAR(stats_doc,
+"stats() -> dict\n\n"
+"Return what has been collected since the last stats_reset(), as a dict\n"
+"mapping names like 'disk_new' or 'Device.read' to dicts with the keys\n"
+"calls, total and max (in seconds), bytes_read, bytes_written, objects, and\n"
+"histogram.  histogram is a tuple whose item i counts the calls that took\n"
+"less than 2**i microseconds, the last one everything slower.  Functions\n"
+"that were never called are left out.");
+
+PyDoc_STRVAR(stats_reset_doc,
+"stats_reset()\n\n"
+"Zero everything stats() returns.");
+
+PyDoc_STRVAR(trace_enable_doc,
+"trace_enable([enable[, size]]) -> boolean\n\n"
+"Turn tracing of libparted device I/O on or off and return its previous\n"
+"state.  While it is on, every read, write and sync libparted does, including\n"
+"the ones inside disk_new(), file_system_probe() and Disk.commit(), is\n"
+"recorded into a ring buffer holding the last size (default 4096) records.\n"
+"Turning it on empties the ring, turning it off keeps the records so they\n"
+"can still be drained.  With no argument, just return the current state.");
+
+PyDoc_STRVAR(trace_drain_doc,
+"trace_drain() -> list\n\n"
+"Remove and return the recorded I/O trace, oldest first, as a list of\n"
+"(op, start, count, seconds, call) tuples.  op is 'read', 'write', 'sync'\n"
+"or 'sync_fast', start and count are in sectors, and call names the _ped\n"
+"function or method it was done for, like stats() does, or is None.");
+
+PyDoc_STRVAR(trace_info_doc,
+"trace_info() -> dict\n\n"
+"Return a dict describing the I/O trace with the keys enabled, size,\n"
+"pending, and dropped, the number of records overwritten before they\n"
+"were drained.");
+
+PyDoc_STRVAR(live_objects_doc,
+"live_objects() -> dict\n\n"
+"Return a dict mapping the name of each _ped type to the number of its\n"
+"objects currently alive, not counting instances of subclasses.  A workload\n"
+"that leaves these higher after a gc.collect() than before leaks objects.");
+
+PyDoc_STRVAR(native_memory_doc,
+"native_memory() -> integer\n\n"
+"Return the number of bytes currently allocated with malloc() in this\n"
+"process, which includes everything libparted allocates.");
+
 PyDoc_STRVAR(register_exn_handler_doc,
 "register_exn_handler(function)\n\n"
 "When parted raises an exception, the function registered here will be called\n"
@@ -275,6 +394,12 @@ static struct PyMethodDef PyPedModuleMethods[] = {
                        constraint_any_doc},
     {"constraint_exact", (PyCFunction) py_ped_constraint_exact, METH_VARARGS,
                          constraint_exact_doc},
+    {"constraint_solver_cache", (PyCFunction) py_ped_constraint_solver_cache,
+                                METH_VARARGS, constraint_solver_cache_doc},
+    {"constraint_solver_cache_clear", (PyCFunction) py_ped_constraint_solver_cache_clear,
+                                      METH_VARARGS, constraint_solver_cache_clear_doc},
+    {"constraint_solver_cache_info", (PyCFunction) py_ped_constraint_solver_cache_info,
+                                     METH_VARARGS, constraint_solver_cache_info_doc},
 
     /* pydevice.c */
     {"device_get", (PyCFunction) py_ped_device_get, METH_VARARGS,
@@ -315,6 +440,18 @@ static struct PyMethodDef PyPedModuleMethods[] = {
                           file_system_probe_doc},
     {"file_system_probe_specific", (PyCFunction) py_ped_file_system_probe_specific,
                                    METH_VARARGS, file_system_probe_specific_doc},
+    {"file_system_probe_coalesce", (PyCFunction) py_ped_file_system_probe_coalesce,
+                                   METH_VARARGS, file_system_probe_coalesce_doc},
+    {"file_system_probe_cache", (PyCFunction) py_ped_file_system_probe_cache,
+                                METH_VARARGS, file_system_probe_cache_doc},
+    {"file_system_probe_cache_clear", (PyCFunction) py_ped_file_system_probe_cache_clear,
+                                      METH_VARARGS, file_system_probe_cache_clear_doc},
+    {"file_system_probe_cache_info", (PyCFunction) py_ped_file_system_probe_cache_info,
+                                     METH_VARARGS, file_system_probe_cache_info_doc},
+    {"file_system_probe_cache_save", (PyCFunction) py_ped_file_system_probe_cache_save,
+                                     METH_VARARGS, file_system_probe_cache_save_doc},
+    {"file_system_probe_cache_load", (PyCFunction) py_ped_file_system_probe_cache_load,
+                                     METH_VARARGS, file_system_probe_cache_load_doc},
     {"file_system_type_get", (PyCFunction) py_ped_file_system_type_get, METH_VARARGS,
                              file_system_type_get_doc},
     {"file_system_type_get_next", (PyCFunction) py_ped_file_system_type_get_next,
@@ -330,6 +467,23 @@ static struct PyMethodDef PyPedModuleMethods[] = {
     {"unit_get_by_name", (PyCFunction) py_ped_unit_get_by_name, METH_VARARGS,
                          unit_get_by_name_doc},
 
+    /* pystats.c */
+    {"stats_enable", (PyCFunction) py_ped_stats_enable, METH_VARARGS,
+                     stats_enable_doc},
+    {"stats", (PyCFunction) py_ped_stats, METH_VARARGS, stats_doc},
+    {"stats_reset", (PyCFunction) py_ped_stats_reset, METH_VARARGS,
+                    stats_reset_doc},
+    {"trace_enable", (PyCFunction) py_ped_trace_enable, METH_VARARGS,
+                     trace_enable_doc},
+    {"trace_drain", (PyCFunction) py_ped_trace_drain, METH_VARARGS,
+                    trace_drain_doc},
+    {"trace_info", (PyCFunction) py_ped_trace_info, METH_VARARGS,
+                   trace_info_doc},
+    {"live_objects", (PyCFunction) py_ped_live_objects, METH_VARARGS,
+                     live_objects_doc},
+    {"native_memory", (PyCFunction) py_ped_native_memory, METH_VARARGS,
+                      native_memory_doc},
+
     { NULL, NULL, 0, NULL }
 };
 
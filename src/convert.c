@@ -165,6 +165,69 @@ PedConstraint *_ped_Constraint2PedConstraint(PyObject *s) {
     return ret;
 }
 
+/*
+ * Return the PedConstraint cached inside a _ped.Constraint, building it
+ * first if there is none or if one of the member Alignment or Geometry
+ * objects has changed underneath it.  The result is owned by the
+ * _ped.Constraint and must not be passed to ped_constraint_destroy().
+ */
+PedConstraint *_ped_Constraint2PedConstraint_cached(PyObject *s) {
+    _ped_Constraint *constraint = (_ped_Constraint *) s;
+    _ped_Alignment *start_align = NULL, *end_align = NULL;
+    PedGeometry *start_range = NULL, *end_range = NULL;
+    PedConstraint *cached = NULL;
+
+    if (constraint == NULL) {
+        PyErr_SetString(PyExc_TypeError, "Empty _ped.Constraint()");
+        return NULL;
+    }
+
+    if (!PyObject_TypeCheck(constraint->start_align, &_ped_Alignment_Type_obj) ||
+        !PyObject_TypeCheck(constraint->end_align, &_ped_Alignment_Type_obj)) {
+        PyErr_SetString(PyExc_TypeError, "_ped.Constraint alignments must be _ped.Alignment objects");
+        return NULL;
+    }
+
+    if (!PyObject_TypeCheck(constraint->start_range, &_ped_Geometry_Type_obj) ||
+        !PyObject_TypeCheck(constraint->end_range, &_ped_Geometry_Type_obj)) {
+        PyErr_SetString(PyExc_TypeError, "_ped.Constraint ranges must be _ped.Geometry objects");
+        return NULL;
+    }
+
+    start_align = (_ped_Alignment *) constraint->start_align;
+    end_align = (_ped_Alignment *) constraint->end_align;
+    start_range = ((_ped_Geometry *) constraint->start_range)->ped_geometry;
+    end_range = ((_ped_Geometry *) constraint->end_range)->ped_geometry;
+    cached = constraint->ped_constraint;
+
+    if (start_range == NULL || end_range == NULL) {
+        PyErr_SetString(PyExc_TypeError, "Empty _ped.Geometry()");
+        return NULL;
+    }
+
+    if (cached != NULL &&
+        (cached->start_align->offset != start_align->offset ||
+         cached->start_align->grain_size != start_align->grain_size ||
+         cached->end_align->offset != end_align->offset ||
+         cached->end_align->grain_size != end_align->grain_size ||
+         cached->start_range->dev != start_range->dev ||
+         cached->start_range->start != start_range->start ||
+         cached->start_range->length != start_range->length ||
+         cached->end_range->dev != end_range->dev ||
+         cached->end_range->start != end_range->start ||
+         cached->end_range->length != end_range->length ||
+         cached->min_size != constraint->min_size ||
+         cached->max_size != constraint->max_size)) {
+        _ped_Constraint_invalidate(constraint);
+    }
+
+    if (constraint->ped_constraint == NULL) {
+        constraint->ped_constraint = _ped_Constraint2PedConstraint(s);
+    }
+
+    return constraint->ped_constraint;
+}
+
 _ped_Constraint *PedConstraint2_ped_Constraint(PedConstraint *constraint) {
     _ped_Constraint *ret = NULL;
     _ped_Alignment *start_align = NULL;
@@ -259,6 +322,8 @@ _ped_Device *PedDevice2_ped_Device(PedDevice *device) {
     if (!ret)
         return (_ped_Device *) PyErr_NoMemory();
 
+    ret->direct_fd = -1;
+
     ret->model = strdup(device->model);
     if (ret->model == NULL) {
         PyErr_NoMemory();
@@ -283,13 +348,8 @@ _ped_Device *PedDevice2_ped_Device(PedDevice *device) {
     ret->did = device->did;
     ret->length = device->length;
 
-    ret->hw_geom = (PyObject *) PedCHSGeometry2_ped_CHSGeometry(&device->hw_geom);
-    if (ret->hw_geom == NULL)
-        goto error;
-
-    ret->bios_geom = (PyObject *) PedCHSGeometry2_ped_CHSGeometry(&device->bios_geom);
-    if (ret->bios_geom == NULL)
-        goto error;
+    ret->hw_geom = device->hw_geom;
+    ret->bios_geom = device->bios_geom;
 
     return ret;
 
@@ -0,0 +1,295 @@
+/*
+ * digest.c
+ * Checksums computed by native code over device data.  These run without
+ * the GIL and touch neither libparted nor the Python API.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ *
+ * This copyrighted material is made available to anyone wishing to use,
+ * modify, copy, or redistribute it subject to the terms and conditions of
+ * the GNU General Public License v.2, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY expressed or implied, including the implied warranties of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.  You should have received a copy of the
+ * GNU General Public License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.  Any Red Hat trademarks that are incorporated in the
+ * source code or documentation are not subject to the GNU General Public
+ * License and may only be used or replicated with the express permission of
+ * Red Hat, Inc.
+ */
+
+#include <pthread.h>
+#include <string.h>
+
+#include "digest.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define DIGEST_CRC32C_SSE42 1
+#include <nmmintrin.h>
+#endif
+
+/*
+ * CRC32C (Castagnoli), as used by iSCSI, ext4 and btrfs metadata.  The
+ * SSE4.2 crc32 instruction is used where the CPU has it, and a slicing-by-8
+ * table lookup otherwise.
+ */
+#define CRC32C_POLY 0x82f63b78
+
+static uint32_t crc32c_table[8][256];
+static pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+static int crc32c_hw = 0;
+
+static void crc32c_init(void) {
+    uint32_t crc;
+    int i, j;
+
+    for (i = 0; i < 256; i++) {
+        crc = i;
+
+        for (j = 0; j < 8; j++) {
+            crc = (crc >> 1) ^ (CRC32C_POLY & -(crc & 1));
+        }
+
+        crc32c_table[0][i] = crc;
+    }
+
+    for (i = 0; i < 256; i++) {
+        crc = crc32c_table[0][i];
+
+        for (j = 1; j < 8; j++) {
+            crc = crc32c_table[0][crc & 0xff] ^ (crc >> 8);
+            crc32c_table[j][i] = crc;
+        }
+    }
+
+#ifdef DIGEST_CRC32C_SSE42
+    __builtin_cpu_init();
+    crc32c_hw = __builtin_cpu_supports("sse4.2") != 0;
+#endif
+}
+
+static uint32_t crc32c_sw(uint32_t crc, const unsigned char *p, size_t size) {
+    uint64_t word;
+
+    while (size && ((uintptr_t) p & 7)) {
+        crc = crc32c_table[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+        size--;
+    }
+
+    while (size >= 8) {
+        memcpy(&word, p, 8);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        word ^= crc;
+        crc = crc32c_table[7][word & 0xff] ^
+              crc32c_table[6][(word >> 8) & 0xff] ^
+              crc32c_table[5][(word >> 16) & 0xff] ^
+              crc32c_table[4][(word >> 24) & 0xff] ^
+              crc32c_table[3][(word >> 32) & 0xff] ^
+              crc32c_table[2][(word >> 40) & 0xff] ^
+              crc32c_table[1][(word >> 48) & 0xff] ^
+              crc32c_table[0][word >> 56];
+        p += 8;
+        size -= 8;
+    }
+
+    while (size--) {
+        crc = crc32c_table[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+#ifdef DIGEST_CRC32C_SSE42
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const unsigned char *p,
+                             size_t size) {
+    uint64_t crc64, word;
+
+    while (size && ((uintptr_t) p & 7)) {
+        crc = _mm_crc32_u8(crc, *p++);
+        size--;
+    }
+
+    crc64 = crc;
+
+    while (size >= 8) {
+        memcpy(&word, p, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+        p += 8;
+        size -= 8;
+    }
+
+    crc = (uint32_t) crc64;
+
+    while (size--) {
+        crc = _mm_crc32_u8(crc, *p++);
+    }
+
+    return crc;
+}
+#endif
+
+/* Whether digest_crc32c() uses the CPU's crc32 instruction. */
+int digest_crc32c_hw(void) {
+    pthread_once(&crc32c_once, crc32c_init);
+    return crc32c_hw;
+}
+
+/* Extend crc, which is 0 to start with, by size bytes of buf. */
+uint32_t digest_crc32c(uint32_t crc, const void *buf, size_t size) {
+    pthread_once(&crc32c_once, crc32c_init);
+    crc = ~crc;
+
+#ifdef DIGEST_CRC32C_SSE42
+    if (crc32c_hw) {
+        return ~crc32c_sse42(crc, buf, size);
+    }
+#endif
+
+    return ~crc32c_sw(crc, buf, size);
+}
+
+/*
+ * XXH64, the 64-bit variant of xxHash.  It needs no special instructions to
+ * run at memory speed; the four independent lanes keep a superscalar CPU
+ * busy on their own.
+ */
+#define XXH_PRIME64_1 0x9e3779b185ebca87ULL
+#define XXH_PRIME64_2 0xc2b2ae3d27d4eb4fULL
+#define XXH_PRIME64_3 0x165667b19e3779f9ULL
+#define XXH_PRIME64_4 0x85ebca77c2b2ae63ULL
+#define XXH_PRIME64_5 0x27d4eb2f165667c5ULL
+
+static inline uint64_t xxh_rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t xxh_read64(const unsigned char *p) {
+    uint64_t v;
+
+    memcpy(&v, p, 8);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+static inline uint32_t xxh_read32(const unsigned char *p) {
+    uint32_t v;
+
+    memcpy(&v, p, 4);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+static inline uint64_t xxh_round(uint64_t acc, uint64_t input) {
+    acc += input * XXH_PRIME64_2;
+    acc = xxh_rotl64(acc, 31);
+    return acc * XXH_PRIME64_1;
+}
+
+static inline uint64_t xxh_merge(uint64_t acc, uint64_t val) {
+    acc ^= xxh_round(0, val);
+    return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+void digest_xxh64_init(digest_xxh64_state *state, uint64_t seed) {
+    memset(state, 0, sizeof(*state));
+    state->seed = seed;
+    state->v[0] = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+    state->v[1] = seed + XXH_PRIME64_2;
+    state->v[2] = seed;
+    state->v[3] = seed - XXH_PRIME64_1;
+}
+
+void digest_xxh64_update(digest_xxh64_state *state, const void *buf,
+                         size_t size) {
+    const unsigned char *p = buf;
+    const unsigned char *end = p + size;
+    size_t fill;
+
+    state->total += size;
+
+    if (state->memsize + size < 32) {
+        memcpy(state->mem + state->memsize, p, size);
+        state->memsize += size;
+        return;
+    }
+
+    if (state->memsize) {
+        fill = 32 - state->memsize;
+        memcpy(state->mem + state->memsize, p, fill);
+        state->v[0] = xxh_round(state->v[0], xxh_read64(state->mem));
+        state->v[1] = xxh_round(state->v[1], xxh_read64(state->mem + 8));
+        state->v[2] = xxh_round(state->v[2], xxh_read64(state->mem + 16));
+        state->v[3] = xxh_round(state->v[3], xxh_read64(state->mem + 24));
+        p += fill;
+        state->memsize = 0;
+    }
+
+    while (end - p >= 32) {
+        state->v[0] = xxh_round(state->v[0], xxh_read64(p));
+        state->v[1] = xxh_round(state->v[1], xxh_read64(p + 8));
+        state->v[2] = xxh_round(state->v[2], xxh_read64(p + 16));
+        state->v[3] = xxh_round(state->v[3], xxh_read64(p + 24));
+        p += 32;
+    }
+
+    if (p < end) {
+        memcpy(state->mem, p, end - p);
+        state->memsize = end - p;
+    }
+}
+
+uint64_t digest_xxh64_final(const digest_xxh64_state *state) {
+    const unsigned char *p = state->mem;
+    const unsigned char *end = p + state->memsize;
+    uint64_t h;
+
+    if (state->total >= 32) {
+        h = xxh_rotl64(state->v[0], 1) + xxh_rotl64(state->v[1], 7) +
+            xxh_rotl64(state->v[2], 12) + xxh_rotl64(state->v[3], 18);
+        h = xxh_merge(h, state->v[0]);
+        h = xxh_merge(h, state->v[1]);
+        h = xxh_merge(h, state->v[2]);
+        h = xxh_merge(h, state->v[3]);
+    } else {
+        h = state->seed + XXH_PRIME64_5;
+    }
+
+    h += state->total;
+
+    while (end - p >= 8) {
+        h ^= xxh_round(0, xxh_read64(p));
+        h = xxh_rotl64(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+        p += 8;
+    }
+
+    if (end - p >= 4) {
+        h ^= (uint64_t) xxh_read32(p) * XXH_PRIME64_1;
+        h = xxh_rotl64(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        p += 4;
+    }
+
+    while (p < end) {
+        h ^= (*p++) * XXH_PRIME64_5;
+        h = xxh_rotl64(h, 11) * XXH_PRIME64_1;
+    }
+
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    h ^= h >> 32;
+
+    return h;
+}
+
+/* vim:tw=78:ts=4:et:sw=4
+ */
@@ -33,7 +33,7 @@ import warnings
 import _ped
 
 __all__ = ['Alignment', 'Constraint', 'Device', 'Disk',
-           'FileSystem', 'Geometry', 'Partition']
+           'FileSystem', 'Geometry', 'LayoutPlan', 'Partition']
 
 from _ped import AlignmentException
 from _ped import CreateException
@@ -65,6 +65,7 @@ from parted.filesystem import fileSystemType
 from parted.geometry import Geometry
 from parted.partition import Partition
 from parted.partition import partitionFlag
+from parted.plan import LayoutPlan
 
 # the enumerated types in _ped need to be available from here too
 from _ped import UNIT_SECTOR
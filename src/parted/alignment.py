@@ -111,6 +111,29 @@ class Alignment(object):
 
         return self.__alignment.is_aligned(geom.getPedGeometry(), sector)
 
+    @localeC
+    def alignUpMany(self, geom, sectors):
+        """Batch form of alignUp().  sectors is a buffer of signed 64-bit
+           integers such as an array('q').  Returns an array('q') of results
+           where -1 marks sectors that could not be aligned inside geom."""
+        return self.__alignment.align_up_many(geom.getPedGeometry(), sectors)
+
+    @localeC
+    def alignDownMany(self, geom, sectors):
+        """Batch form of alignDown().  See alignUpMany()."""
+        return self.__alignment.align_down_many(geom.getPedGeometry(), sectors)
+
+    @localeC
+    def alignNearestMany(self, geom, sectors):
+        """Batch form of alignNearest().  See alignUpMany()."""
+        return self.__alignment.align_nearest_many(geom.getPedGeometry(), sectors)
+
+    @localeC
+    def isAlignedMany(self, geom, sectors):
+        """Batch form of isAligned().  Returns an array('q') holding 1 for
+           each aligned sector inside geom and 0 otherwise."""
+        return self.__alignment.is_aligned_many(geom.getPedGeometry(), sectors)
+
     def getPedAlignment(self):
         """Return the _ped.Alignment object contained in this Alignment.
            For internal module use only."""
@@ -76,7 +76,8 @@ class CachedList(Sequence):
         return str(self._lst)
 
     def __hash__(self):
-        return hash(str(self))
+        self.__rebuildList()
+        return hash(tuple(self._lst))
 
     def count(self, value):
         self.__rebuildList()
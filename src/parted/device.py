@@ -45,6 +45,8 @@ class Device(object):
 
        For information on the individual methods, see help(Device.METHODNAME)"""
 
+    __slots__ = ("__device",)
+
     @localeC
     def __init__(self, path=None, PedDevice=None):
         """Create a new Device object based on the specified path or the
@@ -66,7 +68,10 @@ class Device(object):
         if not isinstance(self, other.__class__):
             return True
 
-        return self.model != other.model or self.path != other.path or self.type != other.type or self.length != other.length
+        return self.__device != other.getPedDevice()
+
+    def __hash__(self):
+        return hash(self.__device)
 
     def __getCHS(self, geometry):
         return (geometry.cylinders, geometry.heads, geometry.sectors)
@@ -117,6 +122,8 @@ class Device(object):
         """
         return bool(self.__device.read_only)
 
+    directIO = property(lambda s: s.__device.direct_io, lambda s, v: setattr(s.__device, "direct_io", v))
+
     @property
     def externalMode(self):
         """True if external access mode is currently activated on this
@@ -188,6 +195,34 @@ class Device(object):
         """Remove all identifying signatures of the partition table."""
         return self.__device.clobber()
 
+    @localeC
+    def findSignatures(self, start=0, count=-1):
+        """Scan count sectors from start, or the whole Device by default,
+           for partition table, RAID, LVM and filesystem signatures.  Returns
+           a list of (offset, name) tuples sorted by the byte offset of each
+           magic."""
+        return self.__device.find_signatures(start, count)
+
+    @localeC
+    def zeroRange(self, start, count, progress=None):
+        """Fill count sectors from start with zeros, letting the kernel do
+           it where the device or image file supports that.  If given,
+           progress is called with a _ped.Timer as the work proceeds."""
+        return self.__device.zero_range(start, count, progress)
+
+    @localeC
+    def discardRange(self, start, count, progress=None):
+        """Discard count sectors from start.  Returns False if this Device
+           does not support discarding."""
+        return self.__device.discard_range(start, count, progress)
+
+    @localeC
+    def mmapView(self, start, count, writable=False):
+        """Return a memoryview of count sectors from start of this Device,
+           which must be an open image file.  The view is read-only unless
+           writable is True."""
+        return self.__device.mmap_view(start, count, writable)
+
     @localeC
     def open(self):
         """Open this Device for read operations."""
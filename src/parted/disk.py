@@ -34,6 +34,10 @@ class Disk(object):
        A Disk object describes a type of device in the system.  Disks
        can hold partitions.  A Disk is a basic operating system-specific
        object."""
+
+    # The Device is built on first use when only a PedDisk is given.
+    __slots__ = ("__disk", "_device", "_partitions")
+
     @localeC
     def __init__(self, device=None, PedDisk=None):
         """Create a new Disk object from the device and type specified.  The
@@ -41,11 +45,7 @@ class Disk(object):
            the diskType hash."""
         if PedDisk:
             self.__disk = PedDisk
-
-            if device is None:
-                self._device = parted.Device(PedDevice=self.__disk.dev)
-            else:
-                self._device = device
+            self._device = device
         elif device is None:
             raise parted.DiskException("no device specified")
         else:
@@ -174,6 +174,21 @@ class Disk(object):
            See getFlag() for more help on working with disk flags."""
         return self.__disk.set_flag(flag, 0)
 
+    @localeC
+    def getFlags(self):
+        """Return the flags set on this disk as a bitmask, with bit
+           1 << flag set for each flag that is on."""
+        return self.__disk.get_flags()
+
+    @localeC
+    def setFlags(self, mask):
+        """Turn on the flags set in mask, as returned by getFlags(), and
+           turn off all others.  A DiskException is raised before anything
+           is changed if a flag in mask is not available, and after the
+           flags are applied if the label would not keep all of them on
+           together."""
+        return self.__disk.set_flags(mask)
+
     @localeC
     def isFlagAvailable(self, flag):
         """Return True if flag is available on this Disk, False
@@ -188,6 +203,9 @@ class Disk(object):
     @property
     def device(self):
         """The underlying Device holding this disk and partitions."""
+        if self._device is None:
+            self._device = parted.Device(PedDevice=self.__disk.dev)
+
         return self._device
 
     type = property(lambda s: s.__disk.type.name, lambda s, v: setattr(s.__disk, "type", parted.diskType[v]))
@@ -392,6 +410,31 @@ class Disk(object):
         except:
             return None
 
+    @localeC
+    def auditAlignment(self, alignment=None):
+        """Check every partition on this Disk against alignment, which
+           defaults to the device's optimum Alignment.  Returns a list of
+           (number, start, end, alignedStart, alignedEnd) tuples for the
+           partitions whose start or end is misaligned."""
+        if alignment is None:
+            return self.__disk.audit_alignment()
+        else:
+            return self.__disk.audit_alignment(alignment.getPedAlignment())
+
+    @localeC
+    def probeFileSystems(self, workers=4):
+        """Detect the filesystem on every partition of this Disk, using up
+           to workers threads.  Returns a dict mapping partition number to
+           the filesystem type name, None if no filesystem was found, or the
+           exception raised while reading that partition."""
+        probed = self.__disk.probe_filesystems(workers=workers)
+
+        for (num, fstype) in probed.items():
+            if isinstance(fstype, _ped.FileSystemType):
+                probed[num] = fstype.name
+
+        return probed
+
     def __filterPartitions(self, fn):
         return [part for part in self.partitions if fn(part)]
 
@@ -405,11 +448,11 @@ class Disk(object):
 
     def getRaidPartitions(self):
         """Return a list of RAID (or normal) Partitions on this Disk."""
-        return self.__filterPartitions(lambda p: p.active and p.getFlag(parted.PARTITION_RAID))
+        return self.__filterPartitions(lambda p: p.getFlags() & (1 << parted.PARTITION_RAID))
 
     def getLVMPartitions(self):
         """Return a list of physical volume-type Partitions on this Disk."""
-        return self.__filterPartitions(lambda p: p.active and p.getFlag(parted.PARTITION_LVM))
+        return self.__filterPartitions(lambda p: p.getFlags() & (1 << parted.PARTITION_LVM))
 
     @localeC
     def getFreeSpaceRegions(self):
@@ -38,6 +38,10 @@ class Geometry(object):
        partition.  It is expressed in terms of a starting sector and a length.
        Many methods (read and write methods in particular) throughout pyparted
        take in a Geometry object as an argument."""
+
+    # The Device is built on first use when only a PedGeometry is given.
+    __slots__ = ("__geometry", "_device")
+
     @localeC
     def __init__(self, device=None, start=None, length=None, end=None,
                  PedGeometry=None):
@@ -46,11 +50,7 @@ class Geometry(object):
            can also be provided."""
         if PedGeometry:
             self.__geometry = PedGeometry
-
-            if device is None:
-                self._device = parted.Device(PedDevice=self.__geometry.dev)
-            else:
-                self._device = device
+            self._device = device
         elif not end:
             self._device = device
             self.__geometry = _ped.Geometry(self.device.getPedDevice(), start, length)
@@ -70,7 +70,10 @@ class Geometry(object):
         if not isinstance(self, other.__class__):
             return True
 
-        return self.device != other.device or self.start != other.start or self.length != other.length
+        return self.__geometry != other.getPedGeometry()
+
+    def __hash__(self):
+        return hash(self.__geometry)
 
     def __str__(self):
         s = ("parted.Geometry instance --\n"
@@ -83,6 +86,9 @@ class Geometry(object):
     @property
     def device(self):
         """The Device this geometry describes."""
+        if self._device is None:
+            self._device = parted.Device(PedDevice=self.__geometry.dev)
+
         return self._device
 
     start = property(lambda s: s.__geometry.start, lambda s, v: s.__geometry.set_start(v))
@@ -191,6 +197,38 @@ class Geometry(object):
            count  -- How many sectors of buf to write out."""
         return self.__geometry.write(buf, offset, count)
 
+    @localeC
+    def copyTo(self, dst, chunkSectors=2048, threads=2, progress=None):
+        """Copy the contents of self to the start of the Geometry dst, which
+           must be at least as large and must not overlap self.
+           chunkSectors -- How many sectors to move per read and write.
+           threads      -- How many threads to copy with.
+           progress     -- If given, called with a _ped.Timer as the copy
+                           proceeds."""
+        return self.__geometry.copy_to(dst.getPedGeometry(), chunkSectors,
+                                       threads, progress)
+
+    @localeC
+    def diff(self, other, chunkSectors=2048, threads=2, progress=None):
+        """Compare the contents of self with the Geometry other, which must
+           be the same size, and return a list of (start, length) sector
+           ranges relative to the start of self where they differ.
+           chunkSectors -- How many sectors to compare at a time.
+           threads      -- How many threads to compare with.
+           progress     -- If given, called with a _ped.Timer as the
+                           comparison proceeds."""
+        return self.__geometry.diff(other.getPedGeometry(), chunkSectors,
+                                    threads, progress)
+
+    @localeC
+    def digest(self, algorithm="sha256", chunkSectors=2048, chunks=False):
+        """Return the hex digest of the contents of self.
+           algorithm    -- 'crc32c', 'xxh64' or 'sha256'.
+           chunkSectors -- How many sectors to read at a time.
+           chunks       -- If True, return a list with the digest of each
+                           chunk instead."""
+        return self.__geometry.digest(algorithm, chunkSectors, chunks)
+
     def getPedGeometry(self):
         """Return the _ped.Geometry object contained in this Geometry.
            For internal module use only."""
@@ -33,7 +33,14 @@ from parted.decorators import localeC
 
 # XXX: add docstrings
 
+# Stands in for a fileSystem not looked up yet, as None means there is none.
+_unknown = object()
+
 class Partition(object):
+    # The Disk, Geometry and FileSystem are built on first use when only a
+    # PedPartition is given, as walking a disk touches few of them.
+    __slots__ = ("__partition", "_disk", "_geometry", "_fileSystem")
+
     # pylint: disable=W0622
     @localeC
     def __init__(self, disk=None, type=None, fs=None, geometry=None, PedPartition=None):
@@ -55,18 +62,9 @@ class Partition(object):
                 self.__partition = _ped.Partition(disk.getPedDisk(), type, geometry.start, geometry.end, parted.fileSystemType[fs.type])
         else:
             self.__partition = PedPartition
-            self._geometry = parted.Geometry(PedGeometry=self.__partition.geom)
-
-            if disk is None:
-                self._disk = parted.Disk(PedDisk=self.__partition.disk)
-            else:
-                self._disk = disk
-
-            if self.__partition.fs_type is None:
-                self._fileSystem = None
-            else:
-                # pylint: disable=E1103
-                self._fileSystem = parted.FileSystem(type=self.__partition.fs_type.name, geometry=self._geometry)
+            self._disk = disk
+            self._geometry = None
+            self._fileSystem = _unknown
 
     def __eq__(self, other):
         return not self.__ne__(other)
@@ -75,7 +73,10 @@ class Partition(object):
         if not isinstance(self, other.__class__):
             return True
 
-        return self.path != other.path or self.type != other.type or self.geometry != other.geometry or self.fileSystem != other.fileSystem
+        return self.__partition != other.getPedPartition()
+
+    def __hash__(self):
+        return hash(self.__partition)
 
     def __str__(self):
         try:
@@ -112,6 +113,9 @@ class Partition(object):
     @property
     def disk(self):
         """The Disk this partition belongs to."""
+        if self._disk is None:
+            self._disk = parted.Disk(PedDisk=self.__partition.disk)
+
         return self._disk
 
     @property
@@ -134,8 +138,27 @@ class Partition(object):
         """The partition number."""
         return self.__partition.num
 
-    fileSystem = property(lambda s: s._fileSystem, lambda s, v: setattr(s, "_fileSystem", v))
-    geometry = property(lambda s: s._geometry, lambda s, v: setattr(s, "_geometry", v))
+    def __getGeometry(self):
+        if self._geometry is None:
+            # Share the Device of the Disk if that has been built already.
+            device = self._disk.device if self._disk is not None else None
+            self._geometry = parted.Geometry(device=device,
+                                             PedGeometry=self.__partition.geom)
+
+        return self._geometry
+
+    def __getFileSystem(self):
+        if self._fileSystem is _unknown:
+            if self.__partition.fs_type is None:
+                self._fileSystem = None
+            else:
+                # pylint: disable=E1103
+                self._fileSystem = parted.FileSystem(type=self.__partition.fs_type.name, geometry=self.geometry)
+
+        return self._fileSystem
+
+    fileSystem = property(lambda s: s.__getFileSystem(), lambda s, v: setattr(s, "_fileSystem", v))
+    geometry = property(lambda s: s.__getGeometry(), lambda s, v: setattr(s, "_geometry", v))
     system = property(lambda s: s.__writeOnly("system"), lambda s, v: s.__partition.set_system(v))
     type = property(lambda s: s.__partition.type, lambda s, v: setattr(s.__partition, "type", v))
 
@@ -161,6 +184,22 @@ class Partition(object):
            partition flags."""
         return self.__partition.set_flag(flag, 0)
 
+    @localeC
+    def getFlags(self):
+        """Return the flags set on this Partition as a bitmask, with bit
+           1 << flag set for each flag that is on.  This reads every flag
+           in one call, where getFlag() reads one."""
+        return self.__partition.get_flags()
+
+    @localeC
+    def setFlags(self, mask):
+        """Turn on the flags set in mask, as returned by getFlags(), and
+           turn off all others.  A PartitionException is raised before
+           anything is changed if a flag in mask is not available, and
+           after the flags are applied if the label would not keep all of
+           them on together."""
+        return self.__partition.set_flags(mask)
+
     @localeC
     def getMaxGeometry(self, constraint):
         """Given a constraint, return the maximum Geometry that self can be
@@ -205,9 +244,10 @@ class Partition(object):
         """Return a comma-separated string representing the flags
            on this partition."""
         flags = []
+        mask = self.getFlags()
 
         for flag in partitionFlag.keys():
-            if self.getFlag(flag):
+            if mask & (1 << flag):
                 flags.append(partitionFlag[flag])
 
         return ', '.join(flags)
@@ -0,0 +1,190 @@
+#
+# plan.py
+# Python bindings for libparted (built on top of the _ped Python module).
+#
+# Copyright (C) 2015 Red Hat, Inc.
+#
+# This copyrighted material is made available to anyone wishing to use,
+# modify, copy, or redistribute it subject to the terms and conditions of
+# the GNU General Public License v.2, or (at your option) any later version.
+# This program is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY expressed or implied, including the implied warranties of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+# Public License for more details.  You should have received a copy of the
+# GNU General Public License along with this program; if not, write to the
+# Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+# 02110-1301, USA.  Any Red Hat trademarks that are incorporated in the
+# source code or documentation are not subject to the GNU General Public
+# License and may only be used or replicated with the express permission of
+# Red Hat, Inc.
+#
+
+import re
+
+import parted
+
+from parted.decorators import localeC
+
+# A size in a plan entry is either an integer number of sectors, a string
+# made of a number and a SI or IEC byte unit (e.g. "512MiB"), a percentage
+# of the usable region (e.g. "25%"), or None meaning "the rest of the disk".
+_sizeRe = re.compile(r"^\s*([0-9]+(?:\.[0-9]+)?)\s*([A-Za-z]*B|%)\s*$")
+
+class LayoutPlan(object):
+    """LayoutPlan()
+
+       A LayoutPlan is a declarative description of a partition layout that
+       can be applied to any number of devices.  The plan is solved once per
+       distinct device geometry (disk label, sector sizes, length and
+       alignment) and the solved partition boundaries are cached, so applying
+       the same plan to a fleet of identical devices only runs the
+       calculation once."""
+    def __init__(self, label, partitions, alignment="optimal"):
+        """Create a new LayoutPlan.  label is a key in the parted.diskType
+           hash.  partitions is a list of dicts, each with a 'size' key and
+           optional 'fs' (a key in parted.fileSystemType) and 'flags' (a list
+           of parted.PARTITION_* flags) keys.  Only the last partition may
+           have a size of None, meaning it takes the remaining space.
+
+           alignment is 'optimal', 'minimal', 'none' or a parted.Alignment
+           and controls where partition boundaries are placed."""
+        if label not in parted.diskType:
+            raise parted.DiskLabelException("unknown disk label %s" % (label,))
+
+        if not partitions:
+            raise parted.PartitionException("no partitions specified")
+
+        for entry in partitions[:-1]:
+            if entry.get("size") is None:
+                raise parted.PartitionException("only the last partition may fill the disk")
+
+        if not isinstance(alignment, parted.Alignment) and \
+           alignment not in ("optimal", "minimal", "none"):
+            raise parted.AlignmentException("invalid alignment policy %s" % (alignment,))
+
+        self._label = label
+        self._partitions = list(partitions)
+        self._alignment = alignment
+        self._solved = {}
+
+    @property
+    def label(self):
+        """The disk label this plan creates."""
+        return self._label
+
+    @property
+    def partitions(self):
+        """The list of partition entries in this plan."""
+        return self._partitions
+
+    def __getAlignment(self, device):
+        if isinstance(self._alignment, parted.Alignment):
+            return self._alignment
+        elif self._alignment == "optimal":
+            return device.optimumAlignment
+        elif self._alignment == "minimal":
+            return device.minimumAlignment
+        else:
+            return parted.Alignment(offset=0, grainSize=1)
+
+    def __toSectors(self, size, device, region):
+        if isinstance(size, parted.string_types):
+            match = _sizeRe.match(size)
+            if not match:
+                raise SyntaxError("%s is not a valid partition size" % (size,))
+
+            (value, unit) = match.groups()
+            if unit == "%":
+                return int(region.length * float(value) / 100)
+            else:
+                return int(parted.sizeToSectors(float(value), unit, device.sectorSize))
+
+        return int(size)
+
+    def __solve(self, device, alignment):
+        # The usable region depends on the label (e.g. GPT reserves room at
+        # both ends of the disk), so ask libparted rather than guessing.
+        disk = parted.freshDisk(device, self._label)
+        region = max(disk.getFreeSpaceRegions(), key=lambda g: g.length)
+
+        if len(self._partitions) > disk.maxPrimaryPartitionCount:
+            raise parted.PartitionException("%s labels hold at most %d partitions" %
+                                            (self._label, disk.maxPrimaryPartitionCount))
+
+        endAlignment = parted.Alignment(offset=alignment.offset - 1,
+                                        grainSize=alignment.grainSize)
+        solved = []
+        sector = region.start
+
+        for entry in self._partitions:
+            start = alignment.alignUp(region, sector)
+
+            if entry.get("size") is None:
+                end = endAlignment.alignDown(region, region.end)
+            else:
+                length = self.__toSectors(entry["size"], device, region)
+                if length <= 0:
+                    raise parted.PartitionException("partition size must be positive")
+
+                end = endAlignment.alignDown(region, start + length - 1)
+
+            if end <= start:
+                raise parted.PartitionException("plan does not fit on %s" % (device.path,))
+
+            solved.append((start, end))
+            sector = end + 1
+
+        return tuple(solved)
+
+    @localeC
+    def solve(self, device):
+        """Return a tuple of (start, end) sector pairs, one for each
+           partition in the plan, for the given Device.  Results are cached
+           by device geometry, so identical devices share one solution."""
+        alignment = self.__getAlignment(device)
+        key = (device.sectorSize, device.physicalSectorSize, device.length,
+               alignment.offset, alignment.grainSize)
+
+        if key not in self._solved:
+            self._solved[key] = self.__solve(device, alignment)
+
+        return self._solved[key]
+
+    @localeC
+    def apply(self, device, commit=True):
+        """Create a fresh disk label on the Device and add the partitions
+           described by this plan.  The new layout is written to the device
+           unless commit is False.  Returns the new Disk."""
+        disk = parted.freshDisk(device, self._label)
+
+        for (entry, (start, end)) in zip(self._partitions, self.solve(device)):
+            geometry = parted.Geometry(device=device, start=start, end=end)
+
+            if entry.get("fs") is None:
+                fs = None
+            else:
+                fs = parted.FileSystem(type=entry["fs"], geometry=geometry)
+
+            partition = parted.Partition(disk=disk, type=parted.PARTITION_NORMAL,
+                                         fs=fs, geometry=geometry)
+            disk.addPartition(partition=partition,
+                              constraint=parted.Constraint(exactGeom=geometry))
+
+            for flag in entry.get("flags", []):
+                partition.setFlag(flag)
+
+        if commit:
+            disk.commit()
+
+        return disk
+
+    def applyAll(self, devices, commit=True):
+        """Apply this plan to every Device in devices and return the list of
+           new Disks.  Devices with the same geometry reuse one solution.
+           libparted keeps global state (the device cache and the exception
+           handler), so the devices are processed one after another."""
+        return [self.apply(device, commit=commit) for device in devices]
+
+    def invalidate(self):
+        """Forget all cached solutions."""
+        self._solved.clear()
@@ -29,6 +29,7 @@
 #include "pyconstraint.h"
 #include "pygeom.h"
 #include "pynatmath.h"
+#include "pystats.h"
 #include "docstrings/pyconstraint.h"
 #include "typeobjects/pyconstraint.h"
 
@@ -48,7 +49,9 @@ void _ped_Constraint_dealloc(_ped_Constraint *self) {
     Py_CLEAR(self->end_range);
     self->end_range = NULL;
 
-    PyObject_GC_Del(self);
+    _ped_Constraint_invalidate(self);
+
+    Py_TYPE(self)->tp_free(self);
 }
 
 int _ped_Constraint_compare(_ped_Constraint *self, PyObject *obj) {
@@ -178,9 +181,18 @@ int _ped_Constraint_clear(_ped_Constraint *self) {
     Py_CLEAR(self->end_range);
     self->end_range = NULL;
 
+    _ped_Constraint_invalidate(self);
+
     return 0;
 }
 
+void _ped_Constraint_invalidate(_ped_Constraint *self) {
+    if (self->ped_constraint) {
+        ped_constraint_destroy(self->ped_constraint);
+        self->ped_constraint = NULL;
+    }
+}
+
 int _ped_Constraint_init(_ped_Constraint *self, PyObject *args,
                          PyObject *kwds) {
     static char *kwlist[] = {"start_align", "end_align", "start_range",
@@ -189,6 +201,8 @@ int _ped_Constraint_init(_ped_Constraint *self, PyObject *args,
     PedAlignment *start_align = NULL, *end_align = NULL;
     PedGeometry *start_range = NULL, *end_range = NULL;
 
+    _ped_Constraint_invalidate(self);
+
     if (kwds == NULL) {
         if (!PyArg_ParseTuple(args, "O!O!O!O!LL",
                               &_ped_Alignment_Type_obj, &self->start_align,
@@ -248,15 +262,16 @@ int _ped_Constraint_init(_ped_Constraint *self, PyObject *args,
     Py_INCREF(self->start_range);
     Py_INCREF(self->end_range);
 
-    /* clean up libparted objects we created */
+    /* clean up libparted objects we created, but keep the constraint */
     ped_alignment_destroy(start_align);
     ped_alignment_destroy(end_align);
-    ped_constraint_destroy(constraint);
+    self->ped_constraint = constraint;
     return 0;
 }
 
 PyObject *_ped_Constraint_get(_ped_Constraint *self, void *closure) {
     char *member = (char *) closure;
+    PyObject *ret = NULL;
 
     if (member == NULL) {
         PyErr_SetString(PyExc_TypeError, "Empty _ped.Constraint()");
@@ -267,20 +282,41 @@ PyObject *_ped_Constraint_get(_ped_Constraint *self, void *closure) {
         return PyLong_FromLongLong(self->min_size);
     } else if (!strcmp(member, "max_size")) {
         return PyLong_FromLongLong(self->max_size);
+    } else if (!strcmp(member, "start_align")) {
+        ret = self->start_align;
+    } else if (!strcmp(member, "end_align")) {
+        ret = self->end_align;
+    } else if (!strcmp(member, "start_range")) {
+        ret = self->start_range;
+    } else if (!strcmp(member, "end_range")) {
+        ret = self->end_range;
     } else {
         PyErr_Format(PyExc_AttributeError, "_ped.Constraint object has no attribute %s", member);
         return NULL;
     }
+
+    if (ret == NULL) {
+        ret = Py_None;
+    }
+
+    Py_INCREF(ret);
+    return ret;
 }
 
 int _ped_Constraint_set(_ped_Constraint *self, PyObject *value, void *closure) {
     char *member = (char *) closure;
+    PyObject **slot = NULL, *old = NULL;
 
     if (member == NULL) {
         PyErr_SetString(PyExc_TypeError, "Empty _ped.Constraint()");
         return -1;
     }
 
+    if (value == NULL) {
+        PyErr_Format(PyExc_AttributeError, "Cannot delete _ped.Constraint attribute %s", member);
+        return -1;
+    }
+
     if (!strcmp(member, "min_size")) {
         self->min_size = PyLong_AsLongLong(value);
         if (PyErr_Occurred()) {
@@ -291,14 +327,179 @@ int _ped_Constraint_set(_ped_Constraint *self, PyObject *value, void *closure) {
         if (PyErr_Occurred()) {
             return -1;
         }
+    } else if (!strcmp(member, "start_align")) {
+        slot = &self->start_align;
+    } else if (!strcmp(member, "end_align")) {
+        slot = &self->end_align;
+    } else if (!strcmp(member, "start_range")) {
+        slot = &self->start_range;
+    } else if (!strcmp(member, "end_range")) {
+        slot = &self->end_range;
     } else {
         PyErr_Format(PyExc_AttributeError, "_ped.Constraint object has no attribute %s", member);
         return -1;
     }
 
+    if (slot) {
+        old = *slot;
+        Py_INCREF(value);
+        *slot = value;
+        Py_XDECREF(old);
+    }
+
+    _ped_Constraint_invalidate(self);
     return 0;
 }
 
+/*
+ * Optional memo of constraint solutions.  Planning the same layout on many
+ * identical disks asks libparted the same question over and over, so when
+ * enabled, solve_max() and solve_nearest() remember their answers in a small
+ * direct-mapped table keyed on what the solve depends on: the constraint
+ * parameters, the device's sector size and length, and the target geometry.
+ * The device itself is not part of the key, so disks of the same size share
+ * entries whatever their path, and a hit is rebuilt against the caller's
+ * device.  Entries only hold sector numbers.
+ */
+#define SOLVER_CACHE_SIZE 256
+#define SOLVER_KEY_LEN    12
+
+#define SOLVE_MAX         1
+#define SOLVE_NEAREST     2
+
+typedef struct {
+    int kind;                           /* 0 for an empty slot */
+    long long sector_size;
+    long long length;
+    long long key[SOLVER_KEY_LEN];
+    PedSector start;                    /* the cached solution */
+    PedSector end;
+} solver_cache_entry;
+
+static solver_cache_entry solver_cache[SOLVER_CACHE_SIZE];
+static int solver_cache_enabled = 0;
+static unsigned long solver_cache_hits = 0;
+static unsigned long solver_cache_misses = 0;
+
+static unsigned long solver_cache_hash_bytes(unsigned long h, const void *buf,
+                                             size_t len) {
+    const unsigned char *p = buf;
+    size_t i;
+
+    /* FNV-1a */
+    for (i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 16777619UL;
+    }
+
+    return h;
+}
+
+/*
+ * Fill in the key for a solve of the given kind and set *devp to the device
+ * the constraint is on.  Returns 0 if the constraint cannot be cached (e.g.,
+ * a member was replaced with something that is not an Alignment or
+ * Geometry), in which case the caller just falls through to the regular
+ * conversion and its error reporting.
+ */
+static int solver_cache_key(_ped_Constraint *self, PedGeometry *target,
+                            int kind, solver_cache_entry *entry,
+                            PedDevice **devp) {
+    _ped_Alignment *start_align = NULL, *end_align = NULL;
+    _ped_Geometry *start_range = NULL, *end_range = NULL;
+    PedDevice *dev = NULL;
+
+    if (!PyObject_TypeCheck(self->start_align, &_ped_Alignment_Type_obj) ||
+        !PyObject_TypeCheck(self->end_align, &_ped_Alignment_Type_obj) ||
+        !PyObject_TypeCheck(self->start_range, &_ped_Geometry_Type_obj) ||
+        !PyObject_TypeCheck(self->end_range, &_ped_Geometry_Type_obj)) {
+        return 0;
+    }
+
+    start_align = (_ped_Alignment *) self->start_align;
+    end_align = (_ped_Alignment *) self->end_align;
+    start_range = (_ped_Geometry *) self->start_range;
+    end_range = (_ped_Geometry *) self->end_range;
+
+    if (start_range->ped_geometry == NULL || end_range->ped_geometry == NULL) {
+        return 0;
+    }
+
+    dev = start_range->ped_geometry->dev;
+    if (end_range->ped_geometry->dev != dev ||
+        (target != NULL && target->dev != dev)) {
+        return 0;
+    }
+
+    memset(entry, 0, sizeof(*entry));
+    entry->kind = kind;
+    entry->sector_size = dev->sector_size;
+    entry->length = dev->length;
+    entry->key[0] = start_align->offset;
+    entry->key[1] = start_align->grain_size;
+    entry->key[2] = end_align->offset;
+    entry->key[3] = end_align->grain_size;
+    entry->key[4] = start_range->ped_geometry->start;
+    entry->key[5] = start_range->ped_geometry->length;
+    entry->key[6] = end_range->ped_geometry->start;
+    entry->key[7] = end_range->ped_geometry->length;
+    entry->key[8] = self->min_size;
+    entry->key[9] = self->max_size;
+
+    if (target != NULL) {
+        entry->key[10] = target->start;
+        entry->key[11] = target->length;
+    }
+
+    *devp = dev;
+    return 1;
+}
+
+static solver_cache_entry *solver_cache_slot(solver_cache_entry *probe) {
+    unsigned long h = 2166136261UL;
+
+    h = solver_cache_hash_bytes(h, &probe->kind, sizeof(probe->kind));
+    h = solver_cache_hash_bytes(h, &probe->sector_size,
+                                sizeof(probe->sector_size));
+    h = solver_cache_hash_bytes(h, &probe->length, sizeof(probe->length));
+    h = solver_cache_hash_bytes(h, probe->key, sizeof(probe->key));
+
+    return &solver_cache[h % SOLVER_CACHE_SIZE];
+}
+
+static int solver_cache_match(solver_cache_entry *slot,
+                              solver_cache_entry *probe) {
+    return slot->kind == probe->kind &&
+           slot->sector_size == probe->sector_size &&
+           slot->length == probe->length &&
+           !memcmp(slot->key, probe->key, sizeof(probe->key));
+}
+
+static void solver_cache_store(solver_cache_entry *slot,
+                               solver_cache_entry *probe,
+                               PedGeometry *geometry) {
+    *slot = *probe;
+    slot->start = geometry->start;
+    slot->end = geometry->end;
+}
+
+/* The cached solution, on the device the caller asked about. */
+static PyObject *solver_cache_result(solver_cache_entry *slot,
+                                     PedDevice *dev) {
+    PedGeometry geometry;
+
+    geometry.dev = dev;
+    geometry.start = slot->start;
+    geometry.end = slot->end;
+    geometry.length = slot->end - slot->start + 1;
+
+    return (PyObject *) PedGeometry2_ped_Geometry(&geometry);
+}
+
+void constraint_solver_cache_flush(void) {
+    memset(solver_cache, 0, sizeof(solver_cache));
+}
+
 /* 1:1 function mappings for constraint.h in libparted */
 PyObject *py_ped_constraint_new_from_min_max(PyObject *s, PyObject *args) {
     PyObject *in_min = NULL, *in_max = NULL;
@@ -406,7 +607,7 @@ PyObject *py_ped_constraint_duplicate(PyObject *s, PyObject *args) {
     PedConstraint *constraint = NULL, *dup_constraint = NULL;
     _ped_Constraint *ret = NULL;
 
-    constraint = _ped_Constraint2PedConstraint(s);
+    constraint = _ped_Constraint2PedConstraint_cached(s);
     if (constraint == NULL) {
         return NULL;
     }
@@ -418,7 +619,6 @@ PyObject *py_ped_constraint_duplicate(PyObject *s, PyObject *args) {
     }
 
     dup_constraint = ped_constraint_duplicate(constraint);
-    ped_constraint_destroy(constraint);
 
     if (dup_constraint) {
         ret = PedConstraint2_ped_Constraint(dup_constraint);
@@ -443,22 +643,18 @@ PyObject *py_ped_constraint_intersect(PyObject *s, PyObject *args) {
         return NULL;
     }
 
-    constraintA = _ped_Constraint2PedConstraint(s);
+    constraintA = _ped_Constraint2PedConstraint_cached(s);
     if (constraintA == NULL) {
         return NULL;
     }
 
-    constraintB = _ped_Constraint2PedConstraint(in_constraintB);
+    constraintB = _ped_Constraint2PedConstraint_cached(in_constraintB);
     if (constraintB == NULL) {
-        ped_constraint_destroy(constraintA);
         return NULL;
     }
 
     constraint = ped_constraint_intersect(constraintA, constraintB);
 
-    ped_constraint_destroy(constraintA);
-    ped_constraint_destroy(constraintB);
-
     if (constraint) {
         ret = PedConstraint2_ped_Constraint(constraint);
     }
@@ -476,18 +672,36 @@ PyObject *py_ped_constraint_solve_max(PyObject *s, PyObject *args) {
     PedConstraint *constraint = NULL;
     PedGeometry *geometry = NULL;
     _ped_Geometry *ret = NULL;
+    solver_cache_entry probe, *slot = NULL;
+    PedDevice *dev = NULL;
+
+    if (solver_cache_enabled &&
+        solver_cache_key((_ped_Constraint *) s, NULL, SOLVE_MAX, &probe,
+                         &dev)) {
+        slot = solver_cache_slot(&probe);
+
+        if (solver_cache_match(slot, &probe)) {
+            solver_cache_hits++;
+            return solver_cache_result(slot, dev);
+        }
+
+        solver_cache_misses++;
+    }
 
-    constraint = _ped_Constraint2PedConstraint(s);
+    constraint = _ped_Constraint2PedConstraint_cached(s);
     if (constraint == NULL) {
         return NULL;
     }
 
     geometry = ped_constraint_solve_max(constraint);
 
-    ped_constraint_destroy(constraint);
-
     if (geometry) {
+        if (slot) {
+            solver_cache_store(slot, &probe, geometry);
+        }
+
         ret = PedGeometry2_ped_Geometry(geometry);
+        ped_geometry_destroy(geometry);
     }
     else {
         if (partedExnRaised) {
@@ -512,29 +726,46 @@ PyObject *py_ped_constraint_solve_nearest(PyObject *s, PyObject *args) {
     PedGeometry *out_geometry = NULL;
     PedGeometry *geometry = NULL;
     _ped_Geometry *ret = NULL;
+    solver_cache_entry probe, *slot = NULL;
+    PedDevice *dev = NULL;
 
     if (!PyArg_ParseTuple(args, "O!", &_ped_Geometry_Type_obj,
                           &in_geometry)) {
         return NULL;
     }
 
-    constraint = _ped_Constraint2PedConstraint(s);
-    if (constraint == NULL) {
+    out_geometry = _ped_Geometry2PedGeometry(in_geometry);
+    if (out_geometry == NULL) {
         return NULL;
     }
 
-    out_geometry = _ped_Geometry2PedGeometry(in_geometry);
-    if (out_geometry == NULL) {
-        ped_constraint_destroy(constraint);
+    if (solver_cache_enabled &&
+        solver_cache_key((_ped_Constraint *) s, out_geometry, SOLVE_NEAREST,
+                         &probe, &dev)) {
+        slot = solver_cache_slot(&probe);
+
+        if (solver_cache_match(slot, &probe)) {
+            solver_cache_hits++;
+            return solver_cache_result(slot, dev);
+        }
+
+        solver_cache_misses++;
+    }
+
+    constraint = _ped_Constraint2PedConstraint_cached(s);
+    if (constraint == NULL) {
         return NULL;
     }
 
     geometry = ped_constraint_solve_nearest(constraint, out_geometry);
 
-    ped_constraint_destroy(constraint);
-
     if (geometry) {
+        if (slot) {
+            solver_cache_store(slot, &probe, geometry);
+        }
+
         ret = PedGeometry2_ped_Geometry(geometry);
+        ped_geometry_destroy(geometry);
     }
     else {
         PyErr_SetString(PyExc_ArithmeticError, "Could not find region nearest to constraint for given geometry");
@@ -555,19 +786,17 @@ PyObject *py_ped_constraint_is_solution(PyObject *s, PyObject *args) {
         return NULL;
     }
 
-    constraint = _ped_Constraint2PedConstraint(s);
+    constraint = _ped_Constraint2PedConstraint_cached(s);
     if (constraint == NULL) {
         return NULL;
     }
 
     out_geometry = _ped_Geometry2PedGeometry(in_geometry);
     if (out_geometry == NULL) {
-        ped_constraint_destroy(constraint);
         return NULL;
     }
 
     ret = ped_constraint_is_solution(constraint, out_geometry);
-    ped_constraint_destroy(constraint);
 
     if (ret) {
         Py_RETURN_TRUE;
@@ -634,5 +863,56 @@ PyObject *py_ped_constraint_exact(PyObject *s, PyObject *args) {
     return (PyObject *) ret;
 }
 
+PyObject *py_ped_constraint_solver_cache(PyObject *s, PyObject *args) {
+    PyObject *in_enable = NULL;
+    int was_enabled = solver_cache_enabled;
+    int enable;
+
+    if (!PyArg_ParseTuple(args, "|O", &in_enable)) {
+        return NULL;
+    }
+
+    if (in_enable != NULL) {
+        enable = PyObject_IsTrue(in_enable);
+        if (enable == -1) {
+            return NULL;
+        }
+
+        solver_cache_enabled = enable;
+
+        if (!enable) {
+            constraint_solver_cache_flush();
+        }
+    }
+
+    return PyBool_FromLong(was_enabled);
+}
+
+PyObject *py_ped_constraint_solver_cache_clear(PyObject *s, PyObject *args) {
+    constraint_solver_cache_flush();
+    solver_cache_hits = 0;
+    solver_cache_misses = 0;
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+PyObject *py_ped_constraint_solver_cache_info(PyObject *s, PyObject *args) {
+    int i, used = 0;
+
+    for (i = 0; i < SOLVER_CACHE_SIZE; i++) {
+        if (solver_cache[i].kind) {
+            used++;
+        }
+    }
+
+    return Py_BuildValue("{s:O,s:k,s:k,s:i,s:i}",
+                         "enabled", solver_cache_enabled ? Py_True : Py_False,
+                         "hits", solver_cache_hits,
+                         "misses", solver_cache_misses,
+                         "size", used,
+                         "max_size", SOLVER_CACHE_SIZE);
+}
+
 /* vim:tw=78:ts=4:et:sw=4
  */
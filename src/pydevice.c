@@ -23,18 +23,26 @@
  */
 
 #include <Python.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 #include "convert.h"
 #include "exceptions.h"
 #include "pyconstraint.h"
 #include "pydevice.h"
+#include "pyfilesys.h"
+#include "pystats.h"
+#include "pytimer.h"
+#include "rawio.h"
 #include "docstrings/pydevice.h"
 #include "typeobjects/pydevice.h"
 
 /* _ped.CHSGeometry functions */
 void _ped_CHSGeometry_dealloc(_ped_CHSGeometry *self) {
-    PyObject_GC_UnTrack(self);
-    PyObject_GC_Del(self);
+    Py_TYPE(self)->tp_free(self);
 }
 
 int _ped_CHSGeometry_compare(_ped_CHSGeometry *self, PyObject *obj) {
@@ -89,14 +97,6 @@ PyObject *_ped_CHSGeometry_str(_ped_CHSGeometry *self) {
     return Py_BuildValue("s", ret);
 }
 
-int _ped_CHSGeometry_traverse(_ped_CHSGeometry *self, visitproc visit, void *arg) {
-    return 0;
-}
-
-int _ped_CHSGeometry_clear(_ped_CHSGeometry *self) {
-    return 0;
-}
-
 PyObject *_ped_CHSGeometry_get(_ped_CHSGeometry *self, void *closure) {
     char *member = (char *) closure;
 
@@ -119,18 +119,14 @@ PyObject *_ped_CHSGeometry_get(_ped_CHSGeometry *self, void *closure) {
 
 /* _ped.Device functions */
 void _ped_Device_dealloc(_ped_Device *self) {
-    PyObject_GC_UnTrack(self);
+    if (self->direct_fd != -1) {
+        close(self->direct_fd);
+    }
 
     free(self->model);
     free(self->path);
 
-    Py_CLEAR(self->hw_geom);
-    self->hw_geom = NULL;
-
-    Py_CLEAR(self->bios_geom);
-    self->bios_geom = NULL;
-
-    PyObject_GC_Del(self);
+    Py_TYPE(self)->tp_free(self);
 }
 
 int _ped_Device_compare(_ped_Device *self, PyObject *obj) {
@@ -147,19 +143,27 @@ int _ped_Device_compare(_ped_Device *self, PyObject *obj) {
     }
 
     comp = (_ped_Device *) obj;
-    if ((!strcmp(self->model, comp->model)) &&
-        (!strcmp(self->path, comp->path)) &&
+    if (self == comp) {
+        return 0;
+    }
+
+    /* libparted keeps one PedDevice per path, so that and the fixed
+     * properties of the device are compared.  open_count, external_mode and
+     * the dirty flags only say what state the device was in when this
+     * object was made, and two objects for the same device may disagree. */
+    if ((!strcmp(self->path, comp->path)) &&
+        (!strcmp(self->model, comp->model)) &&
         (self->type == comp->type) &&
         (self->sector_size == comp->sector_size) &&
         (self->phys_sector_size == comp->phys_sector_size) &&
         (self->length == comp->length) &&
-        (self->open_count == comp->open_count) &&
         (self->read_only == comp->read_only) &&
-        (self->external_mode == comp->external_mode) &&
-        (self->dirty == comp->dirty) &&
-        (self->boot_dirty == comp->dirty) &&
-        (_ped_CHSGeometry_Type_obj.tp_richcompare(self->hw_geom, comp->hw_geom, Py_EQ)) &&
-        (_ped_CHSGeometry_Type_obj.tp_richcompare(self->bios_geom, comp->bios_geom, Py_EQ)) &&
+        (self->hw_geom.cylinders == comp->hw_geom.cylinders) &&
+        (self->hw_geom.heads == comp->hw_geom.heads) &&
+        (self->hw_geom.sectors == comp->hw_geom.sectors) &&
+        (self->bios_geom.cylinders == comp->bios_geom.cylinders) &&
+        (self->bios_geom.heads == comp->bios_geom.heads) &&
+        (self->bios_geom.sectors == comp->bios_geom.sectors) &&
         (self->host == comp->host) &&
         (self->did == comp->did)) {
         return 0;
@@ -184,18 +188,28 @@ PyObject *_ped_Device_richcompare(_ped_Device *a, PyObject *b, int op) {
     }
 }
 
+Py_hash_t _ped_Device_hash(_ped_Device *self) {
+    return _ped_hash_done(_ped_hash_str(PED_HASH_INIT, self->path));
+}
+
 PyObject *_ped_Device_str(_ped_Device *self) {
     char *ret = NULL;
     char *hw_geom = NULL, *bios_geom = NULL;
 
-    hw_geom = PyUnicode_AsUTF8(_ped_CHSGeometry_Type_obj.tp_repr(self->hw_geom));
-    if (hw_geom == NULL) {
-        return NULL;
+    /* Formatted like _ped_CHSGeometry_str() would. */
+    if (asprintf(&hw_geom, "_ped.CHSGeometry instance --\n"
+                           "  cylinders: %d  heads: %d  sectors: %d",
+                 self->hw_geom.cylinders, self->hw_geom.heads,
+                 self->hw_geom.sectors) == -1) {
+        return PyErr_NoMemory();
     }
 
-    bios_geom = PyUnicode_AsUTF8(_ped_CHSGeometry_Type_obj.tp_repr(self->bios_geom));
-    if (bios_geom == NULL) {
-        return NULL;
+    if (asprintf(&bios_geom, "_ped.CHSGeometry instance --\n"
+                             "  cylinders: %d  heads: %d  sectors: %d",
+                 self->bios_geom.cylinders, self->bios_geom.heads,
+                 self->bios_geom.sectors) == -1) {
+        free(hw_geom);
+        return PyErr_NoMemory();
     }
 
     if (asprintf(&ret, "_ped.Device instance --\n"
@@ -211,38 +225,15 @@ PyObject *_ped_Device_str(_ped_Device *self) {
                  self->external_mode, self->dirty, self->boot_dirty,
                  self->host, self->did,
                  hw_geom, bios_geom) == -1) {
+        free(hw_geom);
+        free(bios_geom);
         return PyErr_NoMemory();
     }
 
-    return Py_BuildValue("s", ret);
-}
-
-int _ped_Device_traverse(_ped_Device *self, visitproc visit, void *arg) {
-    int err;
-
-    if (self->hw_geom) {
-        if ((err = visit(self->hw_geom, arg))) {
-            return err;
-        }
-    }
-
-    if (self->bios_geom) {
-        if ((err = visit(self->bios_geom, arg))) {
-            return err;
-        }
-    }
+    free(hw_geom);
+    free(bios_geom);
 
-    return 0;
-}
-
-int _ped_Device_clear(_ped_Device *self) {
-    Py_CLEAR(self->hw_geom);
-    self->hw_geom = NULL;
-
-    Py_CLEAR(self->bios_geom);
-    self->bios_geom = NULL;
-
-    return 0;
+    return Py_BuildValue("s", ret);
 }
 
 PyObject *_ped_Device_get(_ped_Device *self, void *closure) {
@@ -285,12 +276,87 @@ PyObject *_ped_Device_get(_ped_Device *self, void *closure) {
         return Py_BuildValue("h", self->host);
     } else if (!strcmp(member, "did")) {
         return Py_BuildValue("h", self->did);
+    } else if (!strcmp(member, "hw_geom")) {
+        return (PyObject *) PedCHSGeometry2_ped_CHSGeometry(&self->hw_geom);
+    } else if (!strcmp(member, "bios_geom")) {
+        return (PyObject *) PedCHSGeometry2_ped_CHSGeometry(&self->bios_geom);
+    } else if (!strcmp(member, "direct_io")) {
+        return PyBool_FromLong(self->direct_io);
     } else {
         PyErr_Format(PyExc_AttributeError, "_ped.Device object has no attribute %s", member);
         return NULL;
     }
 }
 
+/* Open the descriptor read() and write() use in direct_io mode.  It stays
+ * open until direct_io is cleared or self goes away, so small reads and
+ * writes do not pay for an open() and close() each.  Devices that cannot
+ * be opened for writing get a read-only descriptor, and write() checks
+ * read_only before using it. */
+static int device_direct_open(_ped_Device *self) {
+    int fd, direct;
+
+    fd = rawio_open_direct(self->path, O_RDWR, &direct);
+    if (fd == -1 && (errno == EACCES || errno == EPERM || errno == EROFS)) {
+        fd = rawio_open_direct(self->path, O_RDONLY, &direct);
+    }
+
+    if (fd == -1) {
+        PyErr_Format(IOException, "Could not open device %s: %s",
+                     self->path, strerror(errno));
+        return -1;
+    }
+
+    self->direct_fd = fd;
+    self->direct_odirect = direct;
+    return 0;
+}
+
+int _ped_Device_set(_ped_Device *self, PyObject *value, void *closure) {
+    char *member = (char *) closure;
+    int enable;
+
+    if (member == NULL) {
+        PyErr_SetString(PyExc_TypeError, "Empty _ped.Device()");
+        return -1;
+    }
+
+    if (value == NULL) {
+        PyErr_Format(PyExc_TypeError, "Cannot delete %s", member);
+        return -1;
+    }
+
+    if (!strcmp(member, "direct_io")) {
+        enable = PyObject_IsTrue(value);
+        if (enable == -1) {
+            return -1;
+        }
+
+        if (enable && self->direct_fd == -1) {
+            if (device_direct_open(self) == -1) {
+                return -1;
+            }
+        } else if (!enable && self->direct_fd != -1) {
+            if (self->direct_busy) {
+                PyErr_Format(IOException,
+                             "Device %s has direct I/O in progress",
+                             self->path);
+                return -1;
+            }
+
+            close(self->direct_fd);
+            self->direct_fd = -1;
+        }
+
+        self->direct_io = enable;
+    } else {
+        PyErr_Format(PyExc_AttributeError, "_ped.Device object has no attribute %s", member);
+        return -1;
+    }
+
+    return 0;
+}
+
 /*
  * Returns the _ped.DiskType for the specified _ped.Device.
  * Even though this function is part of pydisk.c, it's a method
@@ -506,12 +572,6 @@ PyObject *py_ped_device_destroy(PyObject *s, PyObject *args) {
 
     ped_device_destroy(device);
 
-    Py_CLEAR(dev->hw_geom);
-    dev->hw_geom = NULL;
-
-    Py_CLEAR(dev->bios_geom);
-    dev->bios_geom = NULL;
-
     Py_CLEAR(dev);
 
     Py_INCREF(Py_None);
@@ -608,11 +668,78 @@ PyObject *py_ped_device_end_external_access(PyObject *s, PyObject *args) {
     }
 }
 
+/* Move count sectors from start between data and fd, which was opened
+ * with O_DIRECT unless direct is 0, staging them in an aligned buffer from
+ * the rawio pool rather than going through libparted's buffered path.
+ * Runs without the GIL.  Returns 0 or an errno value. */
+static int device_direct_io(int fd, int direct, long long sector_size,
+                            long long align, int writing, void *data,
+                            PedSector start, PedSector count) {
+    size_t size = count * sector_size, bufsize = size;
+    long long offset = start * sector_size;
+    unsigned char *buf = NULL;
+    int rc = 0;
+    ssize_t n;
+
+    if (align < sector_size) {
+        align = sector_size;
+    }
+
+    if (align <= 0 || (align & (align - 1))) {
+        align = RAWIO_ALIGN;
+    }
+
+    buf = rawio_buf_get(&bufsize, align);
+    if (buf == NULL) {
+        return ENOMEM;
+    }
+
+    if (writing) {
+        memcpy(buf, data, size);
+
+        if (rawio_pwrite(fd, buf, size, offset) == -1) {
+            rc = errno;
+        }
+    } else {
+        n = rawio_pread(fd, buf, size, offset);
+
+        if (n == -1) {
+            rc = errno;
+        } else if ((size_t) n < size) {
+            rc = EIO;
+        } else {
+            memcpy(data, buf, size);
+        }
+    }
+
+    if (rc == 0 && !direct) {
+        rc = rawio_drop_cache(fd, offset, size, writing);
+    }
+
+    rawio_buf_put(buf, bufsize, align);
+    return rc;
+}
+
+/* Check that count sectors from start lie on device before direct I/O. */
+static int device_direct_check(PedDevice *device, PedSector start,
+                               PedSector count) {
+    if (start < 0 || count < 0 || start + count > device->length) {
+        PyErr_Format(PyExc_ValueError,
+                     "Sectors %lld to %lld are outside of device %s",
+                     start, start + count - 1, device->path);
+        return 0;
+    }
+
+    return 1;
+}
+
 PyObject *py_ped_device_read(PyObject *s, PyObject *args) {
+    _ped_Device *self = (_ped_Device *) s;
     PyObject *ret = NULL;
     PedSector start, count;
     PedDevice *device = NULL;
     char *out_buf = NULL;
+    int rc;
 
     if (!PyArg_ParseTuple(args, "LL", &start, &count)) {
         return NULL;
@@ -633,6 +760,34 @@ PyObject *py_ped_device_read(PyObject *s, PyObject *args) {
         return NULL;
     }
 
+    if (self->direct_io) {
+        if (!device_direct_check(device, start, count)) {
+            return NULL;
+        }
+
+        ret = PyBytes_FromStringAndSize(NULL, count * device->sector_size);
+        if (ret == NULL) {
+            return NULL;
+        }
+
+        self->direct_busy++;
+        Py_BEGIN_ALLOW_THREADS
+        rc = device_direct_io(self->direct_fd, self->direct_odirect,
+                              device->sector_size, device->phys_sector_size,
+                              0, PyBytes_AS_STRING(ret), start, count);
+        Py_END_ALLOW_THREADS
+        self->direct_busy--;
+
+        if (rc) {
+            PyErr_Format(IOException, "Could not read from device %s: %s",
+                         device->path, strerror(rc));
+            Py_DECREF(ret);
+            return NULL;
+        }
+
+        return ret;
+    }
+
     if ((out_buf = malloc(device->sector_size * count)) == NULL) {
         return PyErr_NoMemory();
     }
@@ -658,6 +813,66 @@ PyObject *py_ped_device_read(PyObject *s, PyObject *args) {
     return ret;
 }
 
+/* write() for a Device in direct_io mode, taking any bytes-like buffer. */
+static PyObject *device_direct_write(PyObject *s, PedDevice *device,
+                                     PyObject *in_buf, PedSector start,
+                                     PedSector count) {
+    _ped_Device *self = (_ped_Device *) s;
+    Py_buffer view;
+    int rc;
+
+    if (!device_direct_check(device, start, count)) {
+        return NULL;
+    }
+
+    if (PyObject_GetBuffer(in_buf, &view, PyBUF_SIMPLE) == -1) {
+        return NULL;
+    }
+
+    if (view.len < count * device->sector_size) {
+        PyErr_Format(PyExc_ValueError,
+                     "Buffer holds fewer than %lld sectors", count);
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+
+    if (!device->open_count) {
+        PyErr_Format(IOException, "Device %s is not open.", device->path);
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+
+    if (device->external_mode) {
+        PyErr_Format(IOException, "Device %s is already open for external access.", device->path);
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+
+    if (device->read_only) {
+        PyErr_Format(IOException, "Device %s is read only", device->path);
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+
+    self->direct_busy++;
+    Py_BEGIN_ALLOW_THREADS
+    rc = device_direct_io(self->direct_fd, self->direct_odirect,
+                          device->sector_size, device->phys_sector_size,
+                          1, view.buf, start, count);
+    Py_END_ALLOW_THREADS
+    self->direct_busy--;
+
+    PyBuffer_Release(&view);
+
+    if (rc) {
+        PyErr_Format(IOException, "Could not write to device %s: %s",
+                     device->path, strerror(rc));
+        return NULL;
+    }
+
+    return PyLong_FromLong(1);
+}
+
 PyObject *py_ped_device_write(PyObject *s, PyObject *args) {
     PyObject *in_buf = NULL;
     PedSector start, count, ret;
@@ -673,6 +888,10 @@ PyObject *py_ped_device_write(PyObject *s, PyObject *args) {
         return NULL;
     }
 
+    if (((_ped_Device *) s)->direct_io) {
+        return device_direct_write(s, device, in_buf, start, count);
+    }
+
     out_buf = PyCapsule_GetPointer(in_buf, 0);
     if (out_buf == NULL) {
         return NULL;
@@ -934,5 +1153,556 @@ PyObject *py_ped_device_get_optimum_alignment(PyObject *s, PyObject *args) {
     return (PyObject *) ret;
 }
 
+/*
+ * Signature scanning.  find_signatures() streams the device through a large
+ * buffer with the GIL released and looks for partition table, volume
+ * manager and filesystem magic.  Every magic lives at a fixed place relative
+ * to a sector or block boundary, so instead of searching each chunk byte by
+ * byte, every pattern steps through the buffer at its own stride and only
+ * compares where a match could actually start.  That is fewer compares than
+ * a memmem() pass and ignores the same bytes turning up inside file data.
+ * Consecutive chunks overlap by SCAN_OVERLAP bytes on each side so the whole
+ * structure around a magic is always in the buffer for the check function.
+ */
+#define SCAN_CHUNK      (1024 * 1024)
+#define SCAN_OVERLAP    FS_SIGNATURE_MAX_BLOCK
+#define SCAN_MAX_PATTERNS 64
+
+typedef struct {
+    const char *name;
+    const char *magic;
+    size_t magic_len;
+    long long stride;           /* 0 for the logical sector size */
+    long long phase;            /* position of the magic within a stride */
+    size_t back;                /* distance from the structure to the magic */
+    size_t size;                /* bytes of the structure check looks at */
+    fs_signature_check check;   /* further validation, or NULL */
+    long long below;            /* only match before this offset, or 0 */
+} scan_pattern;
+
+typedef struct {
+    long long offset;
+    const char *name;
+} scan_match;
+
+static unsigned int scan_le32(const unsigned char *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int) p[3] << 24);
+}
+
+static const char *scan_check_lvm(const unsigned char *label,
+                                  const char *name) {
+    return memcmp(label + 24, "LVM2 001", 8) ? NULL : name;
+}
+
+static const char *scan_check_md(const unsigned char *sb, const char *name) {
+    /* 0.90 superblocks have major version 0, all later ones 1. */
+    return scan_le32(sb + 4) <= 1 ? name : NULL;
+}
+
+/* 0x55AA ends boot sectors and plenty of other data, so away from the start
+ * of the device it only counts as a partition table (an MBR or an EBR) if
+ * all four entries in front of it look sane and at least one is in use. */
+static const char *scan_check_dos(const unsigned char *sector,
+                                  const char *name) {
+    const unsigned char *entry = NULL;
+    int i, used = 0;
+
+    for (i = 0; i < 4; i++) {
+        entry = sector + 446 + 16 * i;
+
+        if (entry[0] != 0x00 && entry[0] != 0x80) {
+            return NULL;
+        }
+
+        if (entry[4] != 0) {
+            if (scan_le32(entry + 8) == 0 || scan_le32(entry + 12) == 0) {
+                return NULL;
+            }
+
+            used++;
+        }
+    }
+
+    return used ? name : NULL;
+}
+
+/* An MBR with no partitions in it yet, only accepted in the first sector. */
+static const char *scan_check_dos_empty(const unsigned char *sector,
+                                        const char *name) {
+    static const unsigned char empty[64];
+
+    return memcmp(sector + 446, empty, sizeof(empty)) ? NULL : name;
+}
+
+static const scan_pattern scan_patterns[] = {
+    { "dos", "\x55\xaa", 2, 0, 510, 510, 512, scan_check_dos, 0 },
+    { "dos", "\x55\xaa", 2, 0, 510, 510, 512, scan_check_dos_empty, 512 },
+    { "gpt", "EFI PART", 8, 0, 0, 0, 92, NULL, 0 },
+    { "LVM2_member", "LABELONE", 8, 512, 0, 0, 32, scan_check_lvm, 0 },
+    { "linux_raid_member", "\xfc\x4e\x2b\xa9", 4, 4096, 0, 0, 8,
+      scan_check_md, 0 },
+    { NULL, NULL, 0, 0, 0, 0, 0, NULL, 0 }
+};
+
+/* Build the full pattern list: the table above followed by the filesystem
+ * signatures from pyfilesys.c, which are placed relative to the start of a
+ * filesystem and so can turn up on any 512 byte boundary. */
+static int scan_build_patterns(scan_pattern *out, long long sector_size) {
+    const scan_pattern *pat = NULL;
+    const fs_signature *sig = NULL;
+    int n = 0;
+
+    for (pat = scan_patterns; pat->magic && n < SCAN_MAX_PATTERNS; pat++) {
+        out[n] = *pat;
+
+        if (out[n].stride == 0) {
+            out[n].stride = sector_size;
+        }
+
+        n++;
+    }
+
+    for (sig = fs_signatures; sig->magic && n < SCAN_MAX_PATTERNS; sig++) {
+        out[n].name = sig->name;
+        out[n].magic = sig->magic;
+        out[n].magic_len = sig->magic_len;
+        out[n].stride = 512;
+        out[n].phase = (sig->offset + sig->magic_at) % 512;
+        out[n].back = sig->magic_at;
+        out[n].size = sig->size;
+        out[n].check = sig->check;
+        out[n].below = 0;
+        n++;
+    }
+
+    return n;
+}
+
+typedef struct {
+    scan_match *matches;
+    size_t count;
+    size_t alloc;
+} scan_result;
+
+static int scan_add(scan_result *result, long long offset, const char *name) {
+    scan_match *grown = NULL;
+
+    if (result->count == result->alloc) {
+        result->alloc = result->alloc ? result->alloc * 2 : 64;
+        grown = realloc(result->matches, result->alloc * sizeof(scan_match));
+        if (grown == NULL) {
+            return 0;
+        }
+
+        result->matches = grown;
+    }
+
+    result->matches[result->count].offset = offset;
+    result->matches[result->count].name = name;
+    result->count++;
+    return 1;
+}
+
+/* Look for every pattern whose magic starts in [from, to).  buf holds avail
+ * bytes of the device starting at byte base. */
+static int scan_buffer(const unsigned char *buf, long long base, size_t avail,
+                       long long from, long long to,
+                       const scan_pattern *patterns, int npatterns,
+                       scan_result *result) {
+    const scan_pattern *pat = NULL;
+    const char *name = NULL;
+    long long pos, rel;
+    int i;
+
+    for (i = 0; i < npatterns; i++) {
+        pat = &patterns[i];
+
+        /* First position at or after from that is phase past a boundary. */
+        pos = from - (from % pat->stride) + pat->phase;
+        if (pos < from) {
+            pos += pat->stride;
+        }
+
+        for (; pos < to; pos += pat->stride) {
+            if (pat->below && pos >= pat->below) {
+                break;
+            }
+
+            rel = pos - base;
+
+            if (rel + (long long) pat->magic_len > (long long) avail) {
+                break;
+            }
+
+            if (buf[rel] != (unsigned char) pat->magic[0] ||
+                memcmp(buf + rel, pat->magic, pat->magic_len)) {
+                continue;
+            }
+
+            if (rel < (long long) pat->back ||
+                rel - (long long) pat->back + (long long) pat->size >
+                (long long) avail) {
+                continue;
+            }
+
+            name = pat->name;
+            if (pat->check) {
+                name = pat->check(buf + rel - pat->back, pat->name);
+            }
+
+            if (name && !scan_add(result, pos, name)) {
+                return ENOMEM;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int scan_match_compare(const void *a, const void *b) {
+    const scan_match *x = a, *y = b;
+
+    if (x->offset != y->offset) {
+        return x->offset < y->offset ? -1 : 1;
+    }
+
+    return strcmp(x->name, y->name);
+}
+
+/* Scan bytes [from, to) of the device at path.  Returns 0 or an errno
+ * value.  Safe to call with the GIL released. */
+static int scan_device(const char *path, long long from, long long to,
+                       const scan_pattern *patterns, int npatterns,
+                       scan_result *result) {
+    unsigned char *buf = NULL;
+    long long chunk, base;
+    ssize_t got;
+    int fd, rc = 0;
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return errno;
+    }
+
+    buf = malloc(SCAN_OVERLAP + SCAN_CHUNK + SCAN_OVERLAP);
+    if (buf == NULL) {
+        close(fd);
+        return ENOMEM;
+    }
+
+    for (chunk = from; chunk < to && rc == 0; chunk += SCAN_CHUNK) {
+        base = chunk < SCAN_OVERLAP ? 0 : chunk - SCAN_OVERLAP;
+
+        got = rawio_pread(fd, buf, (chunk - base) + SCAN_CHUNK + SCAN_OVERLAP,
+                          base);
+        if (got == -1) {
+            rc = errno;
+            break;
+        }
+
+        rc = scan_buffer(buf, base, got, chunk,
+                         chunk + SCAN_CHUNK < to ? chunk + SCAN_CHUNK : to,
+                         patterns, npatterns, result);
+
+        if (got < (chunk - base) + SCAN_CHUNK) {
+            break;
+        }
+    }
+
+    free(buf);
+    close(fd);
+
+    if (rc == 0) {
+        qsort(result->matches, result->count, sizeof(scan_match),
+              scan_match_compare);
+    }
+
+    return rc;
+}
+
+PyObject *py_ped_device_find_signatures(PyObject *s, PyObject *args) {
+    PedSector start = 0, count = -1;
+    PedDevice *device = NULL;
+    scan_pattern patterns[SCAN_MAX_PATTERNS];
+    scan_result result = { NULL, 0, 0 };
+    int npatterns, rc;
+    size_t i;
+    PyObject *ret = NULL, *entry = NULL;
+
+    if (!PyArg_ParseTuple(args, "|LL", &start, &count)) {
+        return NULL;
+    }
+
+    device = _ped_Device2PedDevice(s);
+    if (device == NULL) {
+        return NULL;
+    }
+
+    if (count == -1) {
+        count = device->length - start;
+    }
+
+    if (start < 0 || count < 0 || start + count > device->length) {
+        PyErr_Format(PyExc_ValueError,
+                     "Sectors %lld to %lld are outside of device %s",
+                     start, start + count - 1, device->path);
+        return NULL;
+    }
+
+    npatterns = scan_build_patterns(patterns, device->sector_size);
+
+    Py_BEGIN_ALLOW_THREADS
+    rc = scan_device(device->path, start * device->sector_size,
+                     (start + count) * device->sector_size,
+                     patterns, npatterns, &result);
+    Py_END_ALLOW_THREADS
+
+    if (rc) {
+        free(result.matches);
+
+        if (rc == ENOMEM) {
+            return PyErr_NoMemory();
+        }
+
+        PyErr_Format(IOException, "Could not scan device %s: %s",
+                     device->path, strerror(rc));
+        return NULL;
+    }
+
+    ret = PyList_New(result.count);
+    if (ret == NULL) {
+        free(result.matches);
+        return NULL;
+    }
+
+    for (i = 0; i < result.count; i++) {
+        entry = Py_BuildValue("(Ls)", result.matches[i].offset,
+                              result.matches[i].name);
+        if (entry == NULL) {
+            free(result.matches);
+            Py_DECREF(ret);
+            return NULL;
+        }
+
+        PyList_SET_ITEM(ret, i, entry);
+    }
+
+    free(result.matches);
+    return ret;
+}
+
+/*
+ * Bulk zeroing and discarding.  The range is cleared in RANGE_STEP sized
+ * pieces on a private descriptor with the GIL released, and the progress
+ * callable, if any, is updated between pieces.
+ */
+#define RANGE_STEP (256LL * 1024 * 1024)
+
+static PyObject *device_clear_range(PyObject *s, PyObject *args, int op) {
+    PedSector start, count;
+    PyObject *in_progress = NULL;
+    PedDevice *device = NULL;
+    PedTimer *timer = NULL;
+    long long first, offset, end, step;
+    int fd, rc = 0, method = RAWIO_CLEAR_NATIVE;
+
+    if (!PyArg_ParseTuple(args, "LL|O", &start, &count, &in_progress)) {
+        return NULL;
+    }
+
+    if (progress_timer_check(in_progress) == -1) {
+        return NULL;
+    }
+
+    device = _ped_Device2PedDevice(s);
+    if (device == NULL) {
+        return NULL;
+    }
+
+    if (start < 0 || count < 0 || start + count > device->length) {
+        PyErr_Format(PyExc_ValueError,
+                     "Sectors %lld to %lld are outside of device %s",
+                     start, start + count - 1, device->path);
+        return NULL;
+    }
+
+    if (device->read_only) {
+        PyErr_Format(IOException, "Device %s is read only", device->path);
+        return NULL;
+    }
+
+    timer = progress_timer_new(in_progress,
+                               op == RAWIO_ZERO ? "zeroing" : "discarding");
+    if (timer == NULL && PyErr_Occurred()) {
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    fd = open(device->path, O_WRONLY | O_CLOEXEC);
+    if (fd == -1) {
+        rc = errno;
+    }
+    Py_END_ALLOW_THREADS
+
+    first = offset = start * device->sector_size;
+    end = first + count * device->sector_size;
+
+    while (fd != -1 && offset < end) {
+        step = end - offset < RANGE_STEP ? end - offset : RANGE_STEP;
+
+        Py_BEGIN_ALLOW_THREADS
+        rc = rawio_clear(fd, op, offset, step, &method);
+        Py_END_ALLOW_THREADS
+
+        if (rc) {
+            break;
+        }
+
+        offset += step;
+
+        if (progress_timer_update(timer, (float) (offset - first) /
+                                         (end - first)) == -1) {
+            rc = -1;
+            break;
+        }
+    }
+
+    if (fd != -1) {
+        Py_BEGIN_ALLOW_THREADS
+        if (rc == 0 && op == RAWIO_ZERO && fdatasync(fd) == -1) {
+            rc = errno;
+        }
+
+        close(fd);
+        Py_END_ALLOW_THREADS
+    }
+
+    progress_timer_destroy(timer);
+
+    if (rc == -1) {
+        return NULL;
+    } else if (rc == ENOTSUP && op == RAWIO_DISCARD) {
+        Py_RETURN_FALSE;
+    } else if (rc) {
+        PyErr_Format(IOException, "Could not %s sectors %lld to %lld on %s: %s",
+                     op == RAWIO_ZERO ? "zero" : "discard",
+                     start, start + count - 1, device->path, strerror(rc));
+        return NULL;
+    }
+
+    Py_RETURN_TRUE;
+}
+
+PyObject *py_ped_device_zero_range(PyObject *s, PyObject *args) {
+    return device_clear_range(s, args, RAWIO_ZERO);
+}
+
+PyObject *py_ped_device_discard_range(PyObject *s, PyObject *args) {
+    return device_clear_range(s, args, RAWIO_DISCARD);
+}
+
+/* Map count sectors from start of a file-backed Device with the mmap
+ * module and return a memoryview of just those sectors.  The mapping stays
+ * alive for as long as the view, or any slice of it, does. */
+PyObject *py_ped_device_mmap_view(PyObject *s, PyObject *args) {
+    PedSector start, count;
+    PedDevice *device = NULL;
+    PyObject *mmap_mod = NULL, *map = NULL, *view = NULL, *ret = NULL;
+    PyObject *in_writable = NULL;
+    long long offset, base, size, page;
+    int writable = 0, fd, err = 0;
+
+    if (!PyArg_ParseTuple(args, "LL|O", &start, &count, &in_writable)) {
+        return NULL;
+    }
+
+    if (in_writable != NULL) {
+        writable = PyObject_IsTrue(in_writable);
+        if (writable == -1) {
+            return NULL;
+        }
+    }
+
+    device = _ped_Device2PedDevice(s);
+    if (device == NULL) {
+        return NULL;
+    }
+
+    if (device->type != PED_DEVICE_FILE) {
+        PyErr_Format(IOException, "Device %s is not backed by a file.", device->path);
+        return NULL;
+    }
+
+    if (!device->open_count) {
+        PyErr_Format(IOException, "Device %s is not open.", device->path);
+        return NULL;
+    }
+
+    if (device->external_mode) {
+        PyErr_Format(IOException, "Device %s is already open for external access.", device->path);
+        return NULL;
+    }
+
+    if (writable && device->read_only) {
+        PyErr_Format(IOException, "Device %s is read only", device->path);
+        return NULL;
+    }
+
+    if (start < 0 || count <= 0 || start + count > device->length) {
+        PyErr_Format(PyExc_ValueError,
+                     "Sectors %lld to %lld are outside of device %s",
+                     start, start + count - 1, device->path);
+        return NULL;
+    }
+
+    /* mmap offsets must be page aligned, sector offsets need not be. */
+    page = sysconf(_SC_PAGESIZE);
+    offset = start * device->sector_size;
+    size = count * device->sector_size;
+    base = offset - offset % page;
+
+    Py_BEGIN_ALLOW_THREADS
+    fd = open(device->path, (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+    if (fd == -1) {
+        err = errno;
+    }
+    Py_END_ALLOW_THREADS
+
+    if (fd == -1) {
+        PyErr_Format(IOException, "Could not open %s: %s", device->path,
+                     strerror(err));
+        return NULL;
+    }
+
+    /* mmap.mmap() dups the descriptor, so ours can go right away. */
+    mmap_mod = PyImport_ImportModule("mmap");
+    if (mmap_mod != NULL) {
+        map = PyObject_CallMethod(mmap_mod, "mmap", "iniiiL", fd,
+                                  (Py_ssize_t) (offset - base + size),
+                                  MAP_SHARED,
+                                  writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                                  0, base);
+    }
+
+    close(fd);
+    Py_XDECREF(mmap_mod);
+
+    if (map == NULL) {
+        return NULL;
+    }
+
+    view = PyMemoryView_FromObject(map);
+    Py_DECREF(map);
+
+    if (view == NULL) {
+        return NULL;
+    }
+
+    ret = PySequence_GetSlice(view, offset - base, offset - base + size);
+    Py_DECREF(view);
+
+    return ret;
+}
+
 /* vim:tw=78:ts=4:et:sw=4
  */
@@ -29,6 +29,8 @@
 #include "convert.h"
 #include "exceptions.h"
 #include "pydisk.h"
+#include "pyfilesys.h"
+#include "pystats.h"
 #include "docstrings/pydisk.h"
 #include "typeobjects/pydisk.h"
 
@@ -45,7 +47,15 @@ void _ped_Partition_dealloc(_ped_Partition *self) {
     Py_CLEAR(self->fs_type);
     self->fs_type = NULL;
 
-    PyObject_GC_Del(self);
+    Py_TYPE(self)->tp_free(self);
+}
+
+/* The device a partition lives on, or NULL for one not made on a disk. */
+static PedDevice *_ped_Partition_dev(_ped_Partition *self) {
+    if (self->ped_partition->disk == NULL)
+        return NULL;
+
+    return self->ped_partition->disk->dev;
 }
 
 int _ped_Partition_compare(_ped_Partition *self, PyObject *obj) {
@@ -62,11 +72,20 @@ int _ped_Partition_compare(_ped_Partition *self, PyObject *obj) {
     }
 
     comp = (_ped_Partition *) obj;
-    if ((_ped_Disk_Type_obj.tp_richcompare(self->disk, comp->disk, Py_EQ)) &&
-        (_ped_Geometry_Type_obj.tp_richcompare(self->geom, comp->geom, Py_EQ)) &&
+    if (self == comp) {
+        return 0;
+    } else if (self->ped_partition == NULL || comp->ped_partition == NULL) {
+        return 1;
+    }
+
+    /* Partitions read through two Disk objects for the same device are
+     * still equal, so the PedDevice is compared rather than the PedDisk. */
+    if ((_ped_Partition_dev(self) == _ped_Partition_dev(comp)) &&
         (self->ped_partition->num == comp->ped_partition->num) &&
         (self->type == comp->type) &&
-        (_ped_FileSystemType_Type_obj.tp_richcompare(self->fs_type, comp->fs_type, Py_EQ))) {
+        (self->ped_partition->geom.start == comp->ped_partition->geom.start) &&
+        (self->ped_partition->geom.length == comp->ped_partition->geom.length) &&
+        (self->ped_partition->fs_type == comp->ped_partition->fs_type)) {
         return 0;
     } else {
         return 1;
@@ -74,18 +93,11 @@ int _ped_Partition_compare(_ped_Partition *self, PyObject *obj) {
 }
 
 PyObject *_ped_Partition_richcompare(_ped_Partition *a, PyObject *b, int op) {
-    if (op == Py_EQ) {
-        if ((_ped_Partition_Type_obj.tp_richcompare((PyObject *) a, b, Py_EQ))) {
-            Py_RETURN_TRUE;
-        } else {
-            Py_RETURN_FALSE;
-        }
-    } else if (op == Py_NE) {
-        if (!(_ped_Partition_Type_obj.tp_richcompare((PyObject *) a, b, Py_EQ))) {
-            Py_RETURN_TRUE;
-        } else {
-            Py_RETURN_FALSE;
-        }
+    if (op == Py_EQ || op == Py_NE) {
+        int rv = _ped_Partition_compare(a, b);
+        if (PyErr_Occurred())
+            return NULL;
+        return PyBool_FromLong(op == Py_EQ ? rv == 0 : rv != 0);
     } else if ((op == Py_LT) || (op == Py_LE) ||
                (op == Py_GT) || (op == Py_GE)) {
         PyErr_SetString(PyExc_TypeError, "comparison operator not supported for _ped.Partition");
@@ -96,6 +108,21 @@ PyObject *_ped_Partition_richcompare(_ped_Partition *a, PyObject *b, int op) {
     }
 }
 
+Py_hash_t _ped_Partition_hash(_ped_Partition *self) {
+    unsigned long h = PED_HASH_INIT;
+
+    if (self->ped_partition == NULL) {
+        return _ped_hash_done(_ped_hash_add(h, (uintptr_t) self));
+    }
+
+    /* num is left out: it goes from -1 to a real number when the partition
+     * is added to its disk, and that must not move it within a set. */
+    h = _ped_hash_add(h, (uintptr_t) _ped_Partition_dev(self));
+    h = _ped_hash_add(h, self->ped_partition->geom.start);
+    h = _ped_hash_add(h, self->ped_partition->geom.length);
+    return _ped_hash_done(h);
+}
+
 PyObject *_ped_Partition_str(_ped_Partition *self) {
     char *ret = NULL;
     char *disk = NULL, *fs_type = NULL, *geom = NULL;
@@ -299,7 +326,7 @@ void _ped_Disk_dealloc(_ped_Disk *self) {
     Py_CLEAR(self->type);
     self->type = NULL;
 
-    PyObject_GC_Del(self);
+    Py_TYPE(self)->tp_free(self);
 }
 
 int _ped_Disk_compare(_ped_Disk *self, PyObject *obj) {
@@ -444,7 +471,7 @@ int _ped_Disk_init(_ped_Disk *self, PyObject *args, PyObject *kwds) {
 void _ped_DiskType_dealloc(_ped_DiskType *self) {
     PyObject_GC_UnTrack(self);
     free(self->name);
-    PyObject_GC_Del(self);
+    Py_TYPE(self)->tp_free(self);
 }
 
 int _ped_DiskType_compare(_ped_DiskType *self, PyObject *obj) {
@@ -1012,6 +1039,89 @@ PyObject *py_ped_disk_is_flag_available(PyObject *s, PyObject *args) {
     }
 }
 
+PyObject *py_ped_disk_get_flags(PyObject *s, PyObject *args) {
+    PedDisk *disk = NULL;
+    PedDiskFlag flag;
+    unsigned long long mask = 0;
+
+    disk = _ped_Disk2PedDisk(s);
+    if (disk == NULL) {
+        return NULL;
+    }
+
+    for (flag = ped_disk_flag_next(0); flag; flag = ped_disk_flag_next(flag)) {
+        if (ped_disk_is_flag_available(disk, flag) &&
+            ped_disk_get_flag(disk, flag)) {
+            mask |= 1ULL << flag;
+        }
+    }
+
+    return PyLong_FromUnsignedLongLong(mask);
+}
+
+PyObject *py_ped_disk_set_flags(PyObject *s, PyObject *args) {
+    PedDisk *disk = NULL;
+    PedDiskFlag flag;
+    unsigned long long mask, available = 0;
+
+    if (!PyArg_ParseTuple(args, "K", &mask)) {
+        return NULL;
+    }
+
+    disk = _ped_Disk2PedDisk(s);
+    if (disk == NULL) {
+        return NULL;
+    }
+
+    /* Check the whole mask first so that nothing is changed if any of it
+     * cannot be applied. */
+    for (flag = ped_disk_flag_next(0); flag; flag = ped_disk_flag_next(flag)) {
+        if (ped_disk_is_flag_available(disk, flag)) {
+            available |= 1ULL << flag;
+        }
+    }
+
+    if (mask & ~available) {
+        PyErr_Format(DiskException, "Flags 0x%llx are not available on disk %s", mask & ~available, disk->dev->path);
+        return NULL;
+    }
+
+    for (flag = ped_disk_flag_next(0); flag; flag = ped_disk_flag_next(flag)) {
+        int state = (mask >> flag) & 1;
+
+        if (!(available & (1ULL << flag)) ||
+            !ped_disk_get_flag(disk, flag) == !state) {
+            continue;
+        }
+
+        if (ped_disk_set_flag(disk, flag, state) == 0) {
+            if (partedExnRaised) {
+                partedExnRaised = 0;
+
+                if (!PyErr_ExceptionMatches(PartedException) &&
+                    !PyErr_ExceptionMatches(PyExc_NotImplementedError))
+                    PyErr_SetString(DiskException, partedExnMessage);
+            }
+            else
+                PyErr_Format(DiskException, "Could not set flag on disk %s", disk->dev->path);
+
+            return NULL;
+        }
+    }
+
+    /* A label may turn one flag off when another is turned on, so the
+     * mask may not be reachable even though every flag in it is. */
+    for (flag = ped_disk_flag_next(0); flag; flag = ped_disk_flag_next(flag)) {
+        if ((available & (1ULL << flag)) &&
+            !ped_disk_get_flag(disk, flag) != !((mask >> flag) & 1)) {
+            PyErr_Format(DiskException, "Flags 0x%llx cannot all be set on disk %s", mask, disk->dev->path);
+            return NULL;
+        }
+    }
+
+    Py_RETURN_TRUE;
+}
+
 PyObject *py_ped_disk_flag_get_name(PyObject *s, PyObject *args) {
     int flag;
     char *ret = NULL;
@@ -1202,6 +1312,105 @@ PyObject *py_ped_partition_is_flag_available(_ped_Partition *s, PyObject *args)
     }
 }
 
+PyObject *py_ped_partition_get_flags(_ped_Partition *s, PyObject *args) {
+    PedPartition *part = NULL;
+    PedPartitionFlag flag;
+    unsigned long long mask = 0;
+
+    part = _ped_Partition2PedPartition(s);
+    if (part == NULL) {
+        return NULL;
+    }
+
+    /* Free space and metadata carry no flags, and ped_partition_get_flag
+     * would assert on them. */
+    if (!ped_partition_is_active(part)) {
+        return PyLong_FromUnsignedLongLong(0);
+    }
+
+    for (flag = ped_partition_flag_next(0); flag;
+         flag = ped_partition_flag_next(flag)) {
+        if (ped_partition_is_flag_available(part, flag) &&
+            ped_partition_get_flag(part, flag)) {
+            mask |= 1ULL << flag;
+        }
+    }
+
+    return PyLong_FromUnsignedLongLong(mask);
+}
+
+PyObject *py_ped_partition_set_flags(_ped_Partition *s, PyObject *args) {
+    PedPartition *part = NULL;
+    PedPartitionFlag flag;
+    unsigned long long mask, available = 0;
+
+    if (!PyArg_ParseTuple(args, "K", &mask)) {
+        return NULL;
+    }
+
+    part = _ped_Partition2PedPartition(s);
+    if (part == NULL) {
+        return NULL;
+    }
+
+    if (!ped_partition_is_active(part)) {
+        PyErr_Format(PartitionException, "Could not set flags on inactive partition %s%d", part->disk->dev->path, part->num);
+        return NULL;
+    }
+
+    /* Check the whole mask first so that nothing is changed if any of it
+     * cannot be applied. */
+    for (flag = ped_partition_flag_next(0); flag;
+         flag = ped_partition_flag_next(flag)) {
+        if (ped_partition_is_flag_available(part, flag)) {
+            available |= 1ULL << flag;
+        }
+    }
+
+    if (mask & ~available) {
+        PyErr_Format(PartitionException, "Flags 0x%llx are not available on partition %s%d", mask & ~available, part->disk->dev->path, part->num);
+        return NULL;
+    }
+
+    for (flag = ped_partition_flag_next(0); flag;
+         flag = ped_partition_flag_next(flag)) {
+        int state = (mask >> flag) & 1;
+
+        if (!(available & (1ULL << flag)) ||
+            !ped_partition_get_flag(part, flag) == !state) {
+            continue;
+        }
+
+        if (ped_partition_set_flag(part, flag, state) == 0) {
+            if (partedExnRaised) {
+                partedExnRaised = 0;
+
+                if (!PyErr_ExceptionMatches(PartedException) &&
+                    !PyErr_ExceptionMatches(PyExc_NotImplementedError))
+                    PyErr_SetString(PartitionException, partedExnMessage);
+            }
+            else
+                PyErr_Format(PartitionException, "Could not set flag on partition %s%d", part->disk->dev->path, part->num);
+
+            return NULL;
+        }
+    }
+
+    /* A label may turn one flag off when another is turned on, as msdos
+     * does for RAID and LVM, so the mask may not be reachable even though
+     * every flag in it is available. */
+    for (flag = ped_partition_flag_next(0); flag;
+         flag = ped_partition_flag_next(flag)) {
+        if ((available & (1ULL << flag)) &&
+            !ped_partition_get_flag(part, flag) != !((mask >> flag) & 1)) {
+            PyErr_Format(PartitionException, "Flags 0x%llx cannot all be set on partition %s%d", mask, part->disk->dev->path, part->num);
+            return NULL;
+        }
+    }
+
+    Py_RETURN_TRUE;
+}
+
 PyObject *py_ped_partition_set_system(_ped_Partition *s, PyObject *args) {
     PyObject *in_fstype = NULL;
     PedPartition *part = NULL;
@@ -1481,7 +1690,7 @@ PyObject *py_ped_disk_add_partition(PyObject *s, PyObject *args) {
     }
 
     if (in_constraint) {
-        out_constraint = _ped_Constraint2PedConstraint(in_constraint);
+        out_constraint = _ped_Constraint2PedConstraint_cached(in_constraint);
         if (out_constraint == NULL) {
             return NULL;
         }
@@ -1489,9 +1698,6 @@ PyObject *py_ped_disk_add_partition(PyObject *s, PyObject *args) {
 
     ret = ped_disk_add_partition(disk, out_part, out_constraint);
 
-    if (out_constraint)
-        ped_constraint_destroy(out_constraint);
-
     if (ret == 0) {
         if (partedExnRaised) {
             partedExnRaised = 0;
@@ -1658,7 +1864,7 @@ PyObject *py_ped_disk_set_partition_geom(PyObject *s, PyObject *args) {
     }
 
     if (in_constraint != Py_None) {
-        out_constraint = _ped_Constraint2PedConstraint(in_constraint);
+        out_constraint = _ped_Constraint2PedConstraint_cached(in_constraint);
         if (out_constraint == NULL) {
             return NULL;
         }
@@ -1667,9 +1873,6 @@ PyObject *py_ped_disk_set_partition_geom(PyObject *s, PyObject *args) {
     ret = ped_disk_set_partition_geom(disk, out_part, out_constraint,
                                       start, end);
 
-    if (out_constraint)
-        ped_constraint_destroy(out_constraint);
-
     if (ret == 0) {
         if (partedExnRaised) {
             partedExnRaised = 0;
@@ -1722,7 +1925,7 @@ PyObject *py_ped_disk_maximize_partition(PyObject *s, PyObject *args) {
     }
 
     if (in_constraint) {
-        out_constraint = _ped_Constraint2PedConstraint(in_constraint);
+        out_constraint = _ped_Constraint2PedConstraint_cached(in_constraint);
         if (out_constraint == NULL) {
             return NULL;
         }
@@ -1730,9 +1933,6 @@ PyObject *py_ped_disk_maximize_partition(PyObject *s, PyObject *args) {
 
     ret = ped_disk_maximize_partition(disk, out_part, out_constraint);
 
-    if (out_constraint)
-        ped_constraint_destroy(out_constraint);
-
     if (ret == 0) {
         if (partedExnRaised) {
             partedExnRaised = 0;
@@ -1786,7 +1986,7 @@ PyObject *py_ped_disk_get_max_partition_geometry(PyObject *s, PyObject *args) {
     }
 
     if (in_constraint) {
-        out_constraint = _ped_Constraint2PedConstraint(in_constraint);
+        out_constraint = _ped_Constraint2PedConstraint_cached(in_constraint);
         if (out_constraint == NULL) {
             return NULL;
         }
@@ -1794,9 +1994,6 @@ PyObject *py_ped_disk_get_max_partition_geometry(PyObject *s, PyObject *args) {
 
     pass_geom = ped_disk_get_max_partition_geometry(disk, out_part,
                                                     out_constraint);
-    if (out_constraint)
-        ped_constraint_destroy(out_constraint);
-
     if (pass_geom == NULL) {
         if (partedExnRaised) {
             partedExnRaised = 0;
@@ -1981,6 +2178,241 @@ PyObject *py_ped_disk_extended_partition(PyObject *s, PyObject *args) {
     return (PyObject *) ret;
 }
 
+/*
+ * Check every partition on the disk against one alignment in a single pass.
+ * A partition is aligned when its start sector and the sector just past its
+ * end both satisfy the alignment.  Only plain tuples of sector numbers are
+ * returned so large audits do not build Partition or Geometry objects.
+ */
+PyObject *py_ped_disk_audit_alignment(PyObject *s, PyObject *args) {
+    _ped_Alignment *in_alignment = NULL;
+    PedDisk *disk = NULL;
+    PedPartition *part = NULL;
+    PedAlignment *optimum = NULL;
+    PedAlignment start_align, end_align;
+    PedGeometry whole;
+    PedSector start, end;
+    PyObject *ret = NULL, *entry = NULL;
+
+    if (!PyArg_ParseTuple(args, "|O!", &_ped_Alignment_Type_obj,
+                          &in_alignment)) {
+        return NULL;
+    }
+
+    disk = _ped_Disk2PedDisk(s);
+    if (disk == NULL) {
+        return NULL;
+    }
+
+    if (in_alignment) {
+        start_align.offset = in_alignment->offset;
+        start_align.grain_size = in_alignment->grain_size;
+    } else {
+        optimum = ped_device_get_optimum_alignment(disk->dev);
+        if (optimum == NULL) {
+            if (partedExnRaised) {
+                partedExnRaised = 0;
+
+                if (!PyErr_ExceptionMatches(PartedException) &&
+                    !PyErr_ExceptionMatches(PyExc_NotImplementedError))
+                    PyErr_SetString(AlignmentException, partedExnMessage);
+            }
+            else
+                PyErr_Format(AlignmentException, "Could not get optimum alignment for %s", disk->dev->path);
+
+            return NULL;
+        }
+
+        start_align = *optimum;
+        ped_alignment_destroy(optimum);
+    }
+
+    end_align.offset = start_align.offset - 1;
+    end_align.grain_size = start_align.grain_size;
+
+    whole.dev = disk->dev;
+    whole.start = 0;
+    whole.length = disk->dev->length;
+    whole.end = disk->dev->length - 1;
+
+    ret = PyList_New(0);
+    if (ret == NULL) {
+        return NULL;
+    }
+
+    for (part = ped_disk_next_partition(disk, NULL); part;
+         part = ped_disk_next_partition(disk, part)) {
+        if (part->type & (PED_PARTITION_FREESPACE | PED_PARTITION_METADATA |
+                          PED_PARTITION_PROTECTED)) {
+            continue;
+        }
+
+        if (ped_alignment_is_aligned(&start_align, &whole, part->geom.start) &&
+            ped_alignment_is_aligned(&end_align, &whole, part->geom.end)) {
+            continue;
+        }
+
+        start = ped_alignment_align_nearest(&start_align, &whole,
+                                            part->geom.start);
+        end = ped_alignment_align_nearest(&end_align, &whole, part->geom.end);
+
+        entry = Py_BuildValue("(iLLLL)", part->num, part->geom.start,
+                              part->geom.end, start, end);
+        if (entry == NULL || PyList_Append(ret, entry) == -1) {
+            Py_XDECREF(entry);
+            Py_DECREF(ret);
+            return NULL;
+        }
+
+        Py_DECREF(entry);
+    }
+
+    return ret;
+}
+
+PyObject *py_ped_disk_probe_filesystems(PyObject *s, PyObject *args,
+                                        PyObject *kwds) {
+    static char *kwlist[] = {"workers", NULL};
+    int workers = 4, njobs = 0, i;
+    PedDisk *disk = NULL;
+    PedPartition *part = NULL, **parts = NULL;
+    PedFileSystemType *fstype = NULL;
+    fs_probe_job *jobs = NULL;
+    size_t head_size = file_system_probe_coalesce_size();
+    PyObject *ret = NULL, *key = NULL, *value = NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|i", kwlist, &workers)) {
+        return NULL;
+    }
+
+    if (workers < 1) {
+        PyErr_SetString(PyExc_ValueError, "workers must be at least 1");
+        return NULL;
+    }
+
+    disk = _ped_Disk2PedDisk(s);
+    if (disk == NULL) {
+        return NULL;
+    }
+
+    for (part = ped_disk_next_partition(disk, NULL); part;
+         part = ped_disk_next_partition(disk, part)) {
+        if (!(part->type & (PED_PARTITION_FREESPACE | PED_PARTITION_METADATA |
+                            PED_PARTITION_EXTENDED))) {
+            njobs++;
+        }
+    }
+
+    ret = PyDict_New();
+    if (ret == NULL || njobs == 0) {
+        return ret;
+    }
+
+    parts = PyMem_New(PedPartition *, njobs);
+    jobs = PyMem_New(fs_probe_job, njobs);
+    if (parts == NULL || jobs == NULL) {
+        PyErr_NoMemory();
+        goto error;
+    }
+
+    i = 0;
+    for (part = ped_disk_next_partition(disk, NULL); part;
+         part = ped_disk_next_partition(disk, part)) {
+        if (part->type & (PED_PARTITION_FREESPACE | PED_PARTITION_METADATA |
+                          PED_PARTITION_EXTENDED)) {
+            continue;
+        }
+
+        parts[i] = part;
+        jobs[i].offset = part->geom.start * disk->dev->sector_size;
+        jobs[i].length = part->geom.length * disk->dev->sector_size;
+        i++;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    fs_probe_jobs(disk->dev->path, jobs, njobs, workers, head_size);
+    Py_END_ALLOW_THREADS
+
+    for (i = 0; i < njobs; i++) {
+        fstype = NULL;
+
+        if (jobs[i].error) {
+            value = PyObject_CallFunction(IOException, "s",
+                                          strerror(jobs[i].error));
+        } else {
+            if (jobs[i].name) {
+                fstype = ped_file_system_type_get(jobs[i].name);
+            }
+
+            /* Most native matches are the answer.  Rows marked confirm only
+             * name a candidate, and so does anything on a device without
+             * 512 byte sectors, where several of libparted's probes bail
+             * out; libparted has the final say on those. */
+            if (fstype && (jobs[i].confirm ||
+                           disk->dev->sector_size != PED_SECTOR_SIZE_DEFAULT)) {
+                PedGeometry *found = ped_file_system_probe_specific(fstype,
+                                                        &parts[i]->geom);
+
+                if (found) {
+                    ped_geometry_destroy(found);
+                } else {
+                    if (partedExnRaised) {
+                        partedExnRaised = 0;
+                        PyErr_Clear();
+                    }
+
+                    fstype = NULL;
+                }
+            }
+
+            /* Not recognized or not confirmed, so run every probe. */
+            if (fstype == NULL) {
+                fstype = file_system_probe_cached(&parts[i]->geom);
+            }
+
+            if (fstype) {
+                value = (PyObject *) PedFileSystemType2_ped_FileSystemType(fstype);
+            } else if (partedExnRaised) {
+                partedExnRaised = 0;
+
+                if (PyErr_Occurred()) {
+                    goto error;
+                }
+
+                value = PyObject_CallFunction(IOException, "s",
+                                              partedExnMessage);
+            } else {
+                Py_INCREF(Py_None);
+                value = Py_None;
+            }
+        }
+
+        if (value == NULL) {
+            goto error;
+        }
+
+        key = PyLong_FromLong(parts[i]->num);
+        if (key == NULL || PyDict_SetItem(ret, key, value) == -1) {
+            Py_XDECREF(key);
+            Py_DECREF(value);
+            goto error;
+        }
+
+        Py_DECREF(key);
+        Py_DECREF(value);
+    }
+
+    PyMem_Free(parts);
+    PyMem_Free(jobs);
+    return ret;
+
+error:
+    PyMem_Free(parts);
+    PyMem_Free(jobs);
+    Py_DECREF(ret);
+    return NULL;
+}
+
 PyObject *py_ped_disk_new_fresh(PyObject *s, PyObject *args) {
     _ped_Device *in_device = NULL;
     _ped_DiskType *in_type = NULL;
@@ -23,12 +23,21 @@
  */
 
 #include <Python.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "convert.h"
 #include "exceptions.h"
 #include "pydevice.h"
 #include "pyfilesys.h"
 #include "pygeom.h"
+#include "pystats.h"
+#include "rawio.h"
 #include "docstrings/pyfilesys.h"
 #include "typeobjects/pyfilesys.h"
 
@@ -36,7 +45,7 @@
 void _ped_FileSystemType_dealloc(_ped_FileSystemType *self) {
     PyObject_GC_UnTrack(self);
     free(self->name);
-    PyObject_GC_Del(self);
+    Py_TYPE(self)->tp_free(self);
 }
 
 int _ped_FileSystemType_compare(_ped_FileSystemType *self, PyObject *obj) {
@@ -126,7 +135,7 @@ void _ped_FileSystem_dealloc(_ped_FileSystem *self) {
     Py_CLEAR(self->geom);
     self->geom = NULL;
 
-    PyObject_GC_Del(self);
+    Py_TYPE(self)->tp_free(self);
 }
 
 int _ped_FileSystem_compare(_ped_FileSystem *self, PyObject *obj) {
@@ -369,7 +378,7 @@ PyObject *py_ped_file_system_probe(PyObject *s, PyObject *args) {
         return NULL;
     }
 
-    fstype = ped_file_system_probe(out_geom);
+    fstype = file_system_probe_cached(out_geom);
     if (fstype) {
         ret = PedFileSystemType2_ped_FileSystemType(fstype);
     }
@@ -389,3 +398,676 @@ PyObject *py_ped_file_system_probe(PyObject *s, PyObject *args) {
 
     return (PyObject *) ret;
 }
+
+/* Native filesystem signature probing.  libparted's probes read through the
+ * shared PedDevice and report errors through the exception handler, which
+ * calls back into Python, so they cannot run without the GIL.  The table
+ * below recognizes the common filesystems from their superblocks with plain
+ * pread(2) calls on a private descriptor instead, which lets many
+ * partitions be probed at once.  For most rows the check looks at the same
+ * superblock fields libparted's probe does, and a match is the answer.
+ * libparted's FAT and HFS+ probes look further into the volume (the FAT
+ * itself, the alternate volume header at the end), so those rows are marked
+ * confirm and the caller hands them to ped_file_system_probe_specific().  A
+ * region matching more than one filesystem is left to
+ * ped_file_system_probe(), which refuses such volumes, and so is anything
+ * not recognized here.  Device.find_signatures() scans for the same table
+ * across a whole device.
+ */
+static unsigned int le16(const unsigned char *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static unsigned int le32(const unsigned char *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int) p[3] << 24);
+}
+
+static unsigned long long le64(const unsigned char *p) {
+    return le32(p) | ((unsigned long long) le32(p + 4) << 32);
+}
+
+static unsigned int be32(const unsigned char *p) {
+    return ((unsigned int) p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+/* Mirror libparted's ext2 probe: on revision 1, a journal makes it ext3,
+ * and any of the ext4-only features on top of that makes it ext4. */
+static const char *fs_check_ext(const unsigned char *sb, const char *name) {
+    unsigned int compat = le32(sb + 92);
+    unsigned int incompat = le32(sb + 96);
+    unsigned int ro_compat = le32(sb + 100);
+
+    /* Block sizes top out at 64 KiB and only revisions 0 and 1 exist.  This
+     * keeps the two byte magic from matching stray data in a device scan. */
+    if (le32(sb + 24) > 6 || le32(sb + 76) > 1) {
+        return NULL;
+    }
+
+    /* libparted sizes the filesystem from the block count, and follows a
+     * backup superblock (nonzero group number) back to the real start. */
+    if (le32(sb + 4) == 0 || le16(sb + 90) != 0) {
+        return NULL;
+    }
+
+    if (le32(sb + 76) == 0 || !(compat & 0x0004)) {
+        return "ext2";
+    }
+
+    if ((ro_compat & (0x0008 | 0x0010 | 0x0020)) ||
+        (incompat & (0x0040 | 0x0080 | 0x0200))) {
+        return "ext4";
+    }
+
+    return "ext3";
+}
+
+static const char *fs_check_fat(const unsigned char *bs, const char *name) {
+    unsigned int sector_size = le16(bs + 11);
+
+    if (bs[510] != 0x55 || bs[511] != 0xaa) {
+        return NULL;
+    }
+
+    if (sector_size < 512 || sector_size > 4096 ||
+        (sector_size & (sector_size - 1))) {
+        return NULL;
+    }
+
+    return name;
+}
+
+static const char *fs_check_hfs(const unsigned char *vh, const char *name) {
+    unsigned int version = (vh[2] << 8) | vh[3];
+
+    return (version == 4 || version == 5) ? name : NULL;
+}
+
+/* libparted sizes these from the superblock, and a zero size fails there. */
+static const char *fs_check_xfs(const unsigned char *sb, const char *name) {
+    return be32(sb + 4) && (be32(sb + 8) || be32(sb + 12)) ? name : NULL;
+}
+
+static const char *fs_check_ntfs(const unsigned char *bs, const char *name) {
+    return le64(bs + 0x28) ? name : NULL;
+}
+
+static const char *fs_check_jfs(const unsigned char *sb, const char *name) {
+    return le32(sb + 24) >= 512 && le64(sb + 8) ? name : NULL;
+}
+
+static const char *fs_check_reiserfs(const unsigned char *sb,
+                                     const char *name) {
+    return le16(sb + 44) >= 512 && le32(sb) ? name : NULL;
+}
+
+const fs_signature fs_signatures[] = {
+    { 1024, 1024, 56, "\x53\xef", 2, "ext2", fs_check_ext, 0 },
+    { 0, 512, 0, "XFSB", 4, "xfs", fs_check_xfs, 0 },
+    { 65536, 512, 64, "_BHRfS_M", 8, "btrfs", NULL, 0 },
+    { 0, 512, 3, "NTFS    ", 8, "ntfs", fs_check_ntfs, 0 },
+    { 0, 512, 82, "FAT32   ", 8, "fat32", fs_check_fat, 1 },
+    { 0, 512, 54, "FAT16   ", 8, "fat16", fs_check_fat, 1 },
+    { 0, 512, 54, "FAT12   ", 8, "fat16", fs_check_fat, 1 },
+    { 1024, 512, 0, "H+", 2, "hfs+", fs_check_hfs, 1 },
+    { 1024, 512, 0, "HX", 2, "hfsx", fs_check_hfs, 1 },
+    { 32768, 512, 0, "JFS1", 4, "jfs", fs_check_jfs, 0 },
+    { 65536, 512, 52, "ReIsEr2Fs", 9, "reiserfs", fs_check_reiserfs, 0 },
+    { 65536, 512, 52, "ReIsEr3Fs", 9, "reiserfs", fs_check_reiserfs, 0 },
+    { 65536, 512, 52, "ReIsErFs", 8, "reiserfs", fs_check_reiserfs, 0 },
+    { 0, 4096, 4086, "SWAPSPACE2", 10, "linux-swap(v1)", NULL, 0 },
+    { 0, 4096, 4086, "SWAP-SPACE", 10, "linux-swap(v0)", NULL, 0 },
+    { 0, 4096, 4086, "S1SUSPEND", 9, "swsusp", NULL, 0 },
+    { 0, 0, 0, NULL, 0, NULL, NULL, 0 }
+};
+
+/* Read exactly size bytes at offset.  Returns 0 on success, -1 if the
+ * region runs past the end of the device and an errno value otherwise. */
+static int fs_pread(int fd, unsigned char *buf, size_t size, long long offset) {
+    ssize_t n = rawio_pread(fd, buf, size, offset);
+
+    if (n == -1) {
+        return errno;
+    }
+
+    return (size_t) n < size ? -1 : 0;
+}
+
+/* Probe the region described by job on fd, filling in job->name,
+ * job->confirm and job->error.  job->name is left NULL if no row matches or
+ * if rows for different filesystems do, and job->confirm is set if a row
+ * that matched wants libparted to decide.  Does not use libparted or the
+ * Python API.
+ *
+ * With a head buffer, the first head_size bytes of the region are fetched
+ * in a single read and every signature that falls inside them is checked
+ * straight from the buffer; only signatures past its end cost another read.
+ * On high-latency block devices that turns a handful of small reads per
+ * partition into one.  Without one, each distinct block is read on its own.
+ */
+void fs_signature_probe(int fd, fs_probe_job *job, unsigned char *head,
+                        size_t head_size) {
+    const fs_signature *sig = NULL;
+    unsigned char block[FS_SIGNATURE_MAX_BLOCK];
+    const unsigned char *data = NULL;
+    long long block_offset = -1;
+    size_t block_size = 0, head_len = 0;
+    const char *name = NULL;
+    int rc;
+
+    job->name = NULL;
+    job->confirm = 0;
+    job->error = 0;
+
+    if (head != NULL && head_size > 0) {
+        head_len = head_size;
+        if ((long long) head_len > job->length) {
+            head_len = job->length;
+        }
+
+        rc = fs_pread(fd, head, head_len, job->offset);
+        if (rc == -1) {
+            head_len = 0;
+        } else if (rc) {
+            job->error = rc;
+            return;
+        }
+    }
+
+    for (sig = fs_signatures; sig->magic; sig++) {
+        if (sig->offset + (long long) sig->size > job->length) {
+            continue;
+        }
+
+        if (sig->offset + sig->size <= head_len) {
+            data = head + sig->offset;
+        } else {
+            /* Several signatures share a block, so only read when it
+             * changes. */
+            if (sig->offset != block_offset || sig->size != block_size) {
+                rc = fs_pread(fd, block, sig->size, job->offset + sig->offset);
+                block_offset = -1;
+
+                if (rc == -1) {
+                    continue;
+                } else if (rc) {
+                    job->error = rc;
+                    return;
+                }
+
+                block_offset = sig->offset;
+                block_size = sig->size;
+            }
+
+            data = block;
+        }
+
+        if (memcmp(data + sig->magic_at, sig->magic, sig->magic_len)) {
+            continue;
+        }
+
+        name = sig->check ? sig->check(data, sig->name) : sig->name;
+        if (name == NULL) {
+            continue;
+        }
+
+        /* libparted would not pick between two filesystems either. */
+        if (job->name && strcmp(job->name, name)) {
+            job->name = NULL;
+            job->confirm = 0;
+            return;
+        }
+
+        job->name = name;
+        job->confirm |= sig->confirm;
+    }
+}
+
+typedef struct {
+    const char *path;
+    fs_probe_job *jobs;
+    int njobs;
+    int next;
+    size_t head_size;
+    pthread_mutex_t lock;
+} fs_probe_pool;
+
+static void *fs_probe_worker(void *arg) {
+    fs_probe_pool *pool = arg;
+    unsigned char *head = NULL;
+    int fd, err = 0, i;
+
+    fd = open(pool->path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        err = errno;
+    }
+
+    /* Each worker reuses one head buffer for all of its jobs.  If it cannot
+     * be had, fall back to reading the signature blocks one by one. */
+    if (pool->head_size > 0) {
+        head = malloc(pool->head_size);
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        i = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (i >= pool->njobs) {
+            break;
+        }
+
+        if (fd == -1) {
+            pool->jobs[i].name = NULL;
+            pool->jobs[i].error = err;
+        } else {
+            fs_signature_probe(fd, &pool->jobs[i], head,
+                               head ? pool->head_size : 0);
+        }
+    }
+
+    if (fd != -1) {
+        close(fd);
+    }
+
+    free(head);
+
+    return NULL;
+}
+
+/* Run fs_signature_probe() over every job, reading from path with up to
+ * workers threads (the calling thread included) and head buffers of
+ * head_size bytes, or none if head_size is 0.  Safe to call with the GIL
+ * released. */
+void fs_probe_jobs(const char *path, fs_probe_job *jobs, int njobs,
+                   int workers, size_t head_size) {
+    fs_probe_pool pool;
+    pthread_t threads[FS_PROBE_MAX_WORKERS];
+    int started = 0, i;
+
+    pool.path = path;
+    pool.jobs = jobs;
+    pool.njobs = njobs;
+    pool.next = 0;
+    pool.head_size = head_size;
+    pthread_mutex_init(&pool.lock, NULL);
+
+    if (workers > njobs) {
+        workers = njobs;
+    }
+
+    if (workers > FS_PROBE_MAX_WORKERS) {
+        workers = FS_PROBE_MAX_WORKERS;
+    }
+
+    /* If a thread cannot be started the remaining ones pick up its share. */
+    for (i = 1; i < workers; i++) {
+        if (pthread_create(&threads[started], NULL, fs_probe_worker, &pool)) {
+            break;
+        }
+
+        started++;
+    }
+
+    fs_probe_worker(&pool);
+
+    for (i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool.lock);
+}
+
+/* How much of each region Disk.probe_filesystems() reads up front, in KiB.
+ * 0 reads each signature block separately. */
+#define PROBE_COALESCE_MAX_KIB  1024
+
+static int probe_coalesce_kib = 0;
+
+size_t file_system_probe_coalesce_size(void) {
+    return (size_t) probe_coalesce_kib * 1024;
+}
+
+PyObject *py_ped_file_system_probe_coalesce(PyObject *s, PyObject *args) {
+    int was_kib = probe_coalesce_kib;
+    int kib = -1;
+
+    if (!PyArg_ParseTuple(args, "|i", &kib)) {
+        return NULL;
+    }
+
+    if (PyTuple_Size(args) > 0) {
+        if (kib < 0 || kib > PROBE_COALESCE_MAX_KIB) {
+            PyErr_Format(PyExc_ValueError,
+                         "read size must be between 0 and %d KiB",
+                         PROBE_COALESCE_MAX_KIB);
+            return NULL;
+        }
+
+        probe_coalesce_kib = kib;
+    }
+
+    return PyLong_FromLong(was_kib);
+}
+
+/* Filesystem probe cache.  Inventory tools probe the same unchanged
+ * partitions over and over, and ped_file_system_probe() runs every probe
+ * libparted has for each of them.  When enabled, file_system_probe_cached()
+ * remembers the outcome in a direct-mapped table.  Each entry is keyed on
+ * the device identity (path plus st_dev/st_ino/st_rdev), the region, and a
+ * hash of its first PROBE_CACHE_HEAD bytes, so a reformatted or replaced
+ * partition misses.  That window covers every signature in fs_signatures[]
+ * and the superblocks libparted's probes look at near the start of a
+ * partition; a change confined to a backup header further in (HFS+'s
+ * alternate volume header, say) still hits.  The table can be saved to and
+ * loaded from a file so a restarted process starts out warm.
+ */
+#define PROBE_CACHE_SIZE        1024
+#define PROBE_CACHE_HEAD        (68 * 1024)
+#define PROBE_CACHE_NAME_LEN    32
+#define PROBE_CACHE_MAGIC       "PEDPROBE"
+
+typedef struct {
+    int used;
+    unsigned long long path_hash;
+    unsigned long long st_dev;
+    unsigned long long st_ino;
+    unsigned long long st_rdev;
+    long long start;                    /* region, in bytes */
+    long long length;
+    unsigned long long head_hash;
+    char name[PROBE_CACHE_NAME_LEN];    /* empty if nothing was found */
+} probe_cache_entry;
+
+static probe_cache_entry probe_cache[PROBE_CACHE_SIZE];
+static int probe_cache_enabled = 0;
+static unsigned long probe_cache_hits = 0;
+static unsigned long probe_cache_misses = 0;
+
+static unsigned long long probe_cache_hash_bytes(unsigned long long h,
+                                                 const void *buf, size_t len) {
+    const unsigned char *p = buf;
+    size_t i;
+
+    /* 64-bit FNV-1a */
+    for (i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+
+    return h;
+}
+
+/* Fill in the key for geom.  Returns 0 if the device cannot be identified
+ * or read, in which case the caller just probes without the cache. */
+static int probe_cache_key(PedGeometry *geom, probe_cache_entry *entry) {
+    unsigned char *head;
+    struct stat st;
+    size_t size = PROBE_CACHE_HEAD;
+    int fd, rc;
+
+    if (stat(geom->dev->path, &st) == -1) {
+        return 0;
+    }
+
+    memset(entry, 0, sizeof(*entry));
+    entry->used = 1;
+    entry->path_hash = probe_cache_hash_bytes(14695981039346656037ULL,
+                                              geom->dev->path,
+                                              strlen(geom->dev->path));
+    entry->st_dev = st.st_dev;
+    entry->st_ino = st.st_ino;
+    entry->st_rdev = st.st_rdev;
+    entry->start = geom->start * geom->dev->sector_size;
+    entry->length = geom->length * geom->dev->sector_size;
+
+    if (entry->length < (long long) size) {
+        size = entry->length;
+    }
+
+    fd = open(geom->dev->path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return 0;
+    }
+
+    head = malloc(size);
+    if (head == NULL) {
+        close(fd);
+        return 0;
+    }
+
+    rc = fs_pread(fd, head, size, entry->start);
+    close(fd);
+
+    if (rc == 0) {
+        entry->head_hash = probe_cache_hash_bytes(14695981039346656037ULL,
+                                                  head, size);
+    }
+
+    free(head);
+    return rc == 0;
+}
+
+static probe_cache_entry *probe_cache_slot(probe_cache_entry *probe) {
+    unsigned long long h = 14695981039346656037ULL;
+
+    h = probe_cache_hash_bytes(h, &probe->path_hash, sizeof(probe->path_hash));
+    h = probe_cache_hash_bytes(h, &probe->st_ino, sizeof(probe->st_ino));
+    h = probe_cache_hash_bytes(h, &probe->st_rdev, sizeof(probe->st_rdev));
+    h = probe_cache_hash_bytes(h, &probe->start, sizeof(probe->start));
+    h = probe_cache_hash_bytes(h, &probe->length, sizeof(probe->length));
+
+    return &probe_cache[h % PROBE_CACHE_SIZE];
+}
+
+static int probe_cache_match(probe_cache_entry *slot,
+                             probe_cache_entry *probe) {
+    return slot->used &&
+           slot->path_hash == probe->path_hash &&
+           slot->st_dev == probe->st_dev &&
+           slot->st_ino == probe->st_ino &&
+           slot->st_rdev == probe->st_rdev &&
+           slot->start == probe->start &&
+           slot->length == probe->length &&
+           slot->head_hash == probe->head_hash;
+}
+
+/* ped_file_system_probe() behind the probe cache.  On a miss, or when the
+ * cache is off, this is exactly ped_file_system_probe().  Failures that
+ * raised a libparted exception are never cached. */
+PedFileSystemType *file_system_probe_cached(PedGeometry *geom) {
+    probe_cache_entry probe, *slot = NULL;
+    PedFileSystemType *fstype = NULL;
+
+    if (probe_cache_enabled && probe_cache_key(geom, &probe)) {
+        slot = probe_cache_slot(&probe);
+
+        if (probe_cache_match(slot, &probe)) {
+            if (slot->name[0] == '\0') {
+                probe_cache_hits++;
+                return NULL;
+            }
+
+            /* A type that is no longer registered is a miss, not a hit. */
+            fstype = ped_file_system_type_get(slot->name);
+            if (fstype) {
+                probe_cache_hits++;
+                return fstype;
+            }
+        }
+
+        probe_cache_misses++;
+    }
+
+    fstype = ped_file_system_probe(geom);
+
+    if (slot && (fstype || !partedExnRaised)) {
+        *slot = probe;
+
+        if (fstype) {
+            strncpy(slot->name, fstype->name, PROBE_CACHE_NAME_LEN - 1);
+        }
+    }
+
+    return fstype;
+}
+
+void file_system_probe_cache_flush(void) {
+    memset(probe_cache, 0, sizeof(probe_cache));
+}
+
+PyObject *py_ped_file_system_probe_cache(PyObject *s, PyObject *args) {
+    PyObject *in_enable = NULL;
+    int was_enabled = probe_cache_enabled;
+    int enable;
+
+    if (!PyArg_ParseTuple(args, "|O", &in_enable)) {
+        return NULL;
+    }
+
+    if (in_enable != NULL) {
+        enable = PyObject_IsTrue(in_enable);
+        if (enable == -1) {
+            return NULL;
+        }
+
+        probe_cache_enabled = enable;
+
+        if (!enable) {
+            file_system_probe_cache_flush();
+        }
+    }
+
+    return PyBool_FromLong(was_enabled);
+}
+
+PyObject *py_ped_file_system_probe_cache_clear(PyObject *s, PyObject *args) {
+    file_system_probe_cache_flush();
+    probe_cache_hits = 0;
+    probe_cache_misses = 0;
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+PyObject *py_ped_file_system_probe_cache_info(PyObject *s, PyObject *args) {
+    int i, used = 0;
+
+    for (i = 0; i < PROBE_CACHE_SIZE; i++) {
+        if (probe_cache[i].used) {
+            used++;
+        }
+    }
+
+    return Py_BuildValue("{s:O,s:k,s:k,s:i,s:i}",
+                         "enabled", probe_cache_enabled ? Py_True : Py_False,
+                         "hits", probe_cache_hits,
+                         "misses", probe_cache_misses,
+                         "size", used,
+                         "max_size", PROBE_CACHE_SIZE);
+}
+
+/* The cache file is the magic, the entry size, the entry count and then the
+ * used entries as they are laid out in memory.  It is only meant to be read
+ * back on the machine that wrote it, and the entry size check rejects files
+ * from a different build. */
+PyObject *py_ped_file_system_probe_cache_save(PyObject *s, PyObject *args) {
+    char *path = NULL, *tmp = NULL;
+    FILE *f = NULL;
+    unsigned int header[2];
+    int i, ok;
+
+    if (!PyArg_ParseTuple(args, "s", &path)) {
+        return NULL;
+    }
+
+    header[0] = sizeof(probe_cache_entry);
+    header[1] = 0;
+    for (i = 0; i < PROBE_CACHE_SIZE; i++) {
+        if (probe_cache[i].used) {
+            header[1]++;
+        }
+    }
+
+    /* Write a temporary file and rename it over path, so a concurrent
+     * reader or a crash never sees a partial cache. */
+    tmp = malloc(strlen(path) + 5);
+    if (tmp == NULL) {
+        return PyErr_NoMemory();
+    }
+
+    sprintf(tmp, "%s.tmp", path);
+
+    f = fopen(tmp, "wb");
+    if (f == NULL) {
+        PyErr_SetFromErrnoWithFilename(PyExc_IOError, tmp);
+        free(tmp);
+        return NULL;
+    }
+
+    ok = fwrite(PROBE_CACHE_MAGIC, 8, 1, f) == 1 &&
+         fwrite(header, sizeof(header), 1, f) == 1;
+
+    for (i = 0; ok && i < PROBE_CACHE_SIZE; i++) {
+        if (probe_cache[i].used) {
+            ok = fwrite(&probe_cache[i], sizeof(probe_cache_entry), 1, f) == 1;
+        }
+    }
+
+    if (fclose(f) != 0) {
+        ok = 0;
+    }
+
+    if (!ok || rename(tmp, path) == -1) {
+        PyErr_SetFromErrnoWithFilename(PyExc_IOError, path);
+        unlink(tmp);
+        free(tmp);
+        return NULL;
+    }
+
+    free(tmp);
+    return PyLong_FromLong(header[1]);
+}
+
+PyObject *py_ped_file_system_probe_cache_load(PyObject *s, PyObject *args) {
+    char *path = NULL;
+    char magic[8];
+    FILE *f = NULL;
+    unsigned int header[2], i;
+    probe_cache_entry entry;
+    int loaded = 0;
+
+    if (!PyArg_ParseTuple(args, "s", &path)) {
+        return NULL;
+    }
+
+    f = fopen(path, "rb");
+    if (f == NULL) {
+        return PyErr_SetFromErrnoWithFilename(PyExc_IOError, path);
+    }
+
+    if (fread(magic, sizeof(magic), 1, f) != 1 ||
+        fread(header, sizeof(header), 1, f) != 1 ||
+        memcmp(magic, PROBE_CACHE_MAGIC, sizeof(magic)) ||
+        header[0] != sizeof(probe_cache_entry)) {
+        fclose(f);
+        PyErr_Format(PyExc_ValueError, "%s is not a probe cache file", path);
+        return NULL;
+    }
+
+    for (i = 0; i < header[1]; i++) {
+        if (fread(&entry, sizeof(entry), 1, f) != 1) {
+            break;
+        }
+
+        if (!entry.used) {
+            continue;
+        }
+
+        entry.name[PROBE_CACHE_NAME_LEN - 1] = '\0';
+        *probe_cache_slot(&entry) = entry;
+        loaded++;
+    }
+
+    fclose(f);
+    return PyLong_FromLong(loaded);
+}
@@ -23,11 +23,20 @@
  */
 
 #include <Python.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "convert.h"
+#include "digest.h"
 #include "exceptions.h"
 #include "pygeom.h"
 #include "pynatmath.h"
+#include "pystats.h"
+#include "pytimer.h"
+#include "rawio.h"
 #include "docstrings/pygeom.h"
 #include "typeobjects/pygeom.h"
 
@@ -41,7 +50,7 @@ void _ped_Geometry_dealloc(_ped_Geometry *self) {
     Py_CLEAR(self->dev);
     self->dev = NULL;
 
-    PyObject_GC_Del(self);
+    Py_TYPE(self)->tp_free(self);
 }
 
 int _ped_Geometry_compare(_ped_Geometry *self, PyObject *obj) {
@@ -58,7 +67,15 @@ int _ped_Geometry_compare(_ped_Geometry *self, PyObject *obj) {
     }
 
     comp = (_ped_Geometry *) obj;
-    if (PyObject_RichCompareBool(self->dev, comp->dev, Py_EQ) &&
+    if (self == comp) {
+        return 0;
+    } else if (self->ped_geometry == NULL || comp->ped_geometry == NULL) {
+        return 1;
+    }
+
+    /* Both sides were made through ped_device_get(), which hands out the
+     * same PedDevice for the same path, so the pointers can be compared. */
+    if ((self->ped_geometry->dev == comp->ped_geometry->dev) &&
         (self->ped_geometry->start == comp->ped_geometry->start) &&
         (self->ped_geometry->length == comp->ped_geometry->length) &&
         (self->ped_geometry->end == comp->ped_geometry->end)) {
@@ -84,6 +101,19 @@ PyObject *_ped_Geometry_richcompare(_ped_Geometry *a, PyObject *b, int op) {
     }
 }
 
+Py_hash_t _ped_Geometry_hash(_ped_Geometry *self) {
+    unsigned long h = PED_HASH_INIT;
+
+    if (self->ped_geometry == NULL) {
+        return _ped_hash_done(_ped_hash_add(h, (uintptr_t) self));
+    }
+
+    h = _ped_hash_add(h, (uintptr_t) self->ped_geometry->dev);
+    h = _ped_hash_add(h, self->ped_geometry->start);
+    h = _ped_hash_add(h, self->ped_geometry->length);
+    return _ped_hash_done(h);
+}
+
 PyObject *_ped_Geometry_str(_ped_Geometry *self) {
     char *ret = NULL;
     char *dev = NULL;
@@ -750,5 +780,605 @@ PyObject *py_ped_geometry_map(PyObject *s, PyObject *args) {
     return Py_BuildValue("i", ret);
 }
 
+/* Whether the byte ranges of two open files are the same storage and
+ * overlap. */
+static int geometry_ranges_overlap(int fd_a, long long start_a,
+                                   long long size_a, int fd_b,
+                                   long long start_b, long long size_b) {
+    struct stat a, b;
+
+    if (fstat(fd_a, &a) == -1 || fstat(fd_b, &b) == -1) {
+        return 0;
+    }
+
+    if (S_ISBLK(a.st_mode) && S_ISBLK(b.st_mode)) {
+        if (a.st_rdev != b.st_rdev) {
+            return 0;
+        }
+    } else if (a.st_dev != b.st_dev || a.st_ino != b.st_ino) {
+        return 0;
+    }
+
+    return start_a < start_b + size_b && start_b < start_a + size_a;
+}
+
+PyObject *py_ped_geometry_copy_to(PyObject *s, PyObject *args) {
+    PyObject *in_dst = NULL, *in_progress = NULL;
+    PedGeometry *src = NULL, *dst = NULL;
+    PedTimer *timer = NULL;
+    rawio_copy_job job;
+    pthread_t threads[RAWIO_MAX_THREADS];
+    void *buf = NULL;
+    int chunk_sectors = 2048, nthreads = 2, started = 0, more = 1;
+    int src_fd = -1, dst_fd = -1, rc = 0, cancelled = 0;
+    long long size, src_offset, dst_offset, done;
+
+    if (!PyArg_ParseTuple(args, "O!|iiO", &_ped_Geometry_Type_obj, &in_dst,
+                          &chunk_sectors, &nthreads, &in_progress)) {
+        return NULL;
+    }
+
+    if (progress_timer_check(in_progress) == -1) {
+        return NULL;
+    }
+
+    src = _ped_Geometry2PedGeometry(s);
+    if (src == NULL) {
+        return NULL;
+    }
+
+    dst = _ped_Geometry2PedGeometry(in_dst);
+    if (dst == NULL) {
+        return NULL;
+    }
+
+    if (chunk_sectors < 1) {
+        PyErr_SetString(PyExc_ValueError, "chunk_sectors must be at least 1");
+        return NULL;
+    }
+
+    if (nthreads < 1 || nthreads > RAWIO_MAX_THREADS) {
+        PyErr_Format(PyExc_ValueError, "threads must be between 1 and %d",
+                     RAWIO_MAX_THREADS);
+        return NULL;
+    }
+
+    size = src->length * src->dev->sector_size;
+    src_offset = src->start * src->dev->sector_size;
+    dst_offset = dst->start * dst->dev->sector_size;
+
+    if (dst->length * dst->dev->sector_size < size) {
+        PyErr_SetString(PyExc_ValueError,
+                        "destination Geometry is smaller than self");
+        return NULL;
+    }
+
+    if (dst->dev->read_only) {
+        PyErr_Format(IOException, "Device %s is read only", dst->dev->path);
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    src_fd = open(src->dev->path, O_RDONLY | O_CLOEXEC);
+    if (src_fd == -1) {
+        rc = errno;
+    } else {
+        dst_fd = open(dst->dev->path, O_WRONLY | O_CLOEXEC);
+        if (dst_fd == -1) {
+            rc = errno;
+        }
+    }
+    Py_END_ALLOW_THREADS
+
+    if (rc) {
+        PyErr_Format(IOException, "Could not open %s: %s",
+                     src_fd == -1 ? src->dev->path : dst->dev->path,
+                     strerror(rc));
+        goto out;
+    }
+
+    /* Chunks are copied out of order, so overlapping ranges would read
+     * data that has already been overwritten. */
+    if (geometry_ranges_overlap(src_fd, src_offset, size, dst_fd, dst_offset,
+                                size)) {
+        PyErr_SetString(PyExc_ValueError,
+                        "destination Geometry overlaps with self");
+        goto out;
+    }
+
+    if (posix_memalign(&buf, RAWIO_ALIGN,
+                       (size_t) chunk_sectors * src->dev->sector_size)) {
+        buf = NULL;
+        PyErr_NoMemory();
+        goto out;
+    }
+
+    timer = progress_timer_new(in_progress, "copying");
+    if (timer == NULL && PyErr_Occurred()) {
+        goto out;
+    }
+
+    rawio_copy_init(&job, src_fd, src_offset, dst_fd, dst_offset, size,
+                    (size_t) chunk_sectors * src->dev->sector_size);
+    started = rawio_copy_start(&job, threads, nthreads);
+
+    /* This thread copies as well, reporting progress after every chunk. */
+    while (more) {
+        Py_BEGIN_ALLOW_THREADS
+        more = rawio_copy_work(&job, buf, 1);
+        Py_END_ALLOW_THREADS
+
+        pthread_mutex_lock(&job.lock);
+        done = job.done;
+        pthread_mutex_unlock(&job.lock);
+
+        if (more && size > 0 &&
+            progress_timer_update(timer, (float) done / size) == -1) {
+            pthread_mutex_lock(&job.lock);
+            job.cancel = 1;
+            pthread_mutex_unlock(&job.lock);
+            cancelled = 1;
+            break;
+        }
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    rawio_copy_join(threads, started);
+
+    rc = job.error;
+    if (rc == 0 && !cancelled && fdatasync(dst_fd) == -1) {
+        rc = errno;
+    }
+    Py_END_ALLOW_THREADS
+
+    rawio_copy_destroy(&job);
+
+    if (cancelled) {
+        goto out;
+    } else if (rc) {
+        PyErr_Format(IOException, "Could not copy from %s to %s: %s",
+                     src->dev->path, dst->dev->path, strerror(rc));
+        goto out;
+    }
+
+    progress_timer_update(timer, 1.0);
+
+out:
+    progress_timer_destroy(timer);
+    free(buf);
+
+    if (src_fd != -1) {
+        close(src_fd);
+    }
+
+    if (dst_fd != -1) {
+        close(dst_fd);
+    }
+
+    if (PyErr_Occurred()) {
+        return NULL;
+    }
+
+    Py_RETURN_TRUE;
+}
+
+/* Turn the per-chunk flags of a diff into a list of (start, length) tuples
+ * in Sectors from the start of the Geometry, merging adjacent chunks. */
+static PyObject *geometry_diff_ranges(const unsigned char *differs,
+                                      long long nchunks, long long chunk,
+                                      long long length) {
+    PyObject *ret = NULL, *range = NULL;
+    long long i, first;
+
+    ret = PyList_New(0);
+    if (ret == NULL) {
+        return NULL;
+    }
+
+    for (i = 0; i < nchunks; i++) {
+        if (!differs[i]) {
+            continue;
+        }
+
+        first = i;
+        while (i + 1 < nchunks && differs[i + 1]) {
+            i++;
+        }
+
+        range = Py_BuildValue("(LL)", first * chunk,
+                              ((i + 1) * chunk < length ?
+                               (i + 1) * chunk : length) - first * chunk);
+        if (range == NULL || PyList_Append(ret, range) == -1) {
+            Py_XDECREF(range);
+            Py_DECREF(ret);
+            return NULL;
+        }
+
+        Py_DECREF(range);
+    }
+
+    return ret;
+}
+
+PyObject *py_ped_geometry_diff(PyObject *s, PyObject *args) {
+    PyObject *in_other = NULL, *in_progress = NULL, *ret = NULL;
+    PedGeometry *geom = NULL, *other = NULL;
+    PedTimer *timer = NULL;
+    rawio_diff_job job;
+    pthread_t threads[RAWIO_MAX_THREADS];
+    unsigned char *differs = NULL;
+    void *buf = NULL;
+    int chunk_sectors = 2048, nthreads = 2, started = 0, more = 1;
+    int geom_fd = -1, other_fd = -1, rc = 0, cancelled = 0;
+    long long size, chunk, nchunks, done;
+
+    if (!PyArg_ParseTuple(args, "O!|iiO", &_ped_Geometry_Type_obj, &in_other,
+                          &chunk_sectors, &nthreads, &in_progress)) {
+        return NULL;
+    }
+
+    if (progress_timer_check(in_progress) == -1) {
+        return NULL;
+    }
+
+    geom = _ped_Geometry2PedGeometry(s);
+    if (geom == NULL) {
+        return NULL;
+    }
+
+    other = _ped_Geometry2PedGeometry(in_other);
+    if (other == NULL) {
+        return NULL;
+    }
+
+    if (chunk_sectors < 1) {
+        PyErr_SetString(PyExc_ValueError, "chunk_sectors must be at least 1");
+        return NULL;
+    }
+
+    if (nthreads < 1 || nthreads > RAWIO_MAX_THREADS) {
+        PyErr_Format(PyExc_ValueError, "threads must be between 1 and %d",
+                     RAWIO_MAX_THREADS);
+        return NULL;
+    }
+
+    size = geom->length * geom->dev->sector_size;
+    if (other->length * other->dev->sector_size != size) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Geometry is not the same size as self");
+        return NULL;
+    }
+
+    chunk = (long long) chunk_sectors * geom->dev->sector_size;
+    nchunks = (size + chunk - 1) / chunk;
+
+    differs = calloc(nchunks ? nchunks : 1, 1);
+    if (differs == NULL) {
+        return PyErr_NoMemory();
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    geom_fd = open(geom->dev->path, O_RDONLY | O_CLOEXEC);
+    if (geom_fd == -1) {
+        rc = errno;
+    } else {
+        other_fd = open(other->dev->path, O_RDONLY | O_CLOEXEC);
+        if (other_fd == -1) {
+            rc = errno;
+        }
+    }
+    Py_END_ALLOW_THREADS
+
+    if (rc) {
+        PyErr_Format(IOException, "Could not open %s: %s",
+                     geom_fd == -1 ? geom->dev->path : other->dev->path,
+                     strerror(rc));
+        goto out;
+    }
+
+    if (posix_memalign(&buf, RAWIO_ALIGN, 2 * (size_t) chunk)) {
+        buf = NULL;
+        PyErr_NoMemory();
+        goto out;
+    }
+
+    timer = progress_timer_new(in_progress, "comparing");
+    if (timer == NULL && PyErr_Occurred()) {
+        goto out;
+    }
+
+    rawio_diff_init(&job, geom_fd, geom->start * geom->dev->sector_size,
+                    other_fd, other->start * other->dev->sector_size, size,
+                    chunk, differs);
+    started = rawio_diff_start(&job, threads, nthreads);
+
+    /* This thread compares as well, reporting progress after every chunk. */
+    while (more) {
+        Py_BEGIN_ALLOW_THREADS
+        more = rawio_diff_work(&job, buf, 1);
+        Py_END_ALLOW_THREADS
+
+        pthread_mutex_lock(&job.lock);
+        done = job.done;
+        pthread_mutex_unlock(&job.lock);
+
+        if (more && size > 0 &&
+            progress_timer_update(timer, (float) done / size) == -1) {
+            pthread_mutex_lock(&job.lock);
+            job.cancel = 1;
+            pthread_mutex_unlock(&job.lock);
+            cancelled = 1;
+            break;
+        }
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    rawio_copy_join(threads, started);
+    Py_END_ALLOW_THREADS
+
+    rc = job.error;
+    rawio_diff_destroy(&job);
+
+    if (cancelled) {
+        goto out;
+    } else if (rc) {
+        PyErr_Format(IOException, "Could not compare %s with %s: %s",
+                     geom->dev->path, other->dev->path, strerror(rc));
+        goto out;
+    }
+
+    progress_timer_update(timer, 1.0);
+
+    if (!PyErr_Occurred()) {
+        ret = geometry_diff_ranges(differs, nchunks, chunk_sectors,
+                                   geom->length);
+    }
+
+out:
+    progress_timer_destroy(timer);
+    free(buf);
+    free(differs);
+
+    if (geom_fd != -1) {
+        close(geom_fd);
+    }
+
+    if (other_fd != -1) {
+        close(other_fd);
+    }
+
+    return ret;
+}
+
+/* Algorithms for digest(), in the order of geometry_digest_names. */
+#define DIGEST_CRC32C   0
+#define DIGEST_XXH64    1
+#define DIGEST_SHA256   2
+
+static const char *geometry_digest_names[] = {"crc32c", "xxh64", "sha256",
+                                              NULL};
+
+/* Format a native checksum the way hashlib's hexdigest() would. */
+static PyObject *geometry_digest_hex(int algorithm, uint64_t value) {
+    char hex[17];
+
+    if (algorithm == DIGEST_CRC32C) {
+        snprintf(hex, sizeof(hex), "%08x", (uint32_t) value);
+    } else {
+        snprintf(hex, sizeof(hex), "%016llx", (unsigned long long) value);
+    }
+
+    return PyUnicode_FromString(hex);
+}
+
+/* Feed size bytes of buf to the hashlib object hash. */
+static int geometry_digest_update(PyObject *hash, unsigned char *buf,
+                                  long long size) {
+    PyObject *view = NULL, *ret = NULL;
+
+    view = PyMemoryView_FromMemory((char *) buf, size, PyBUF_READ);
+    if (view == NULL) {
+        return -1;
+    }
+
+    /* hashlib drops the GIL itself for updates of this size. */
+    ret = PyObject_CallMethod(hash, "update", "O", view);
+    Py_DECREF(view);
+
+    if (ret == NULL) {
+        return -1;
+    }
+
+    Py_DECREF(ret);
+    return 0;
+}
+
+PyObject *py_ped_geometry_digest(PyObject *s, PyObject *args) {
+    const char *name = "sha256";
+    int chunk_sectors = 2048, per_chunk = 0, algorithm, fd = -1, rc = 0;
+    PedGeometry *geom = NULL;
+    PyObject *hashlib = NULL, *hash = NULL, *item = NULL, *ret = NULL;
+    PyObject *in_per_chunk = NULL;
+    unsigned char *buf = NULL;
+    size_t bufsize = 0;
+    long long offset, end, chunk, size;
+    ssize_t n;
+    uint64_t value = 0;
+    uint32_t crc = 0;
+    digest_xxh64_state xxh;
+
+    if (!PyArg_ParseTuple(args, "|siO", &name, &chunk_sectors,
+                          &in_per_chunk)) {
+        return NULL;
+    }
+
+    if (in_per_chunk != NULL) {
+        per_chunk = PyObject_IsTrue(in_per_chunk);
+        if (per_chunk == -1) {
+            return NULL;
+        }
+    }
+
+    for (algorithm = 0; geometry_digest_names[algorithm] != NULL; algorithm++) {
+        if (!strcmp(name, geometry_digest_names[algorithm])) {
+            break;
+        }
+    }
+
+    if (geometry_digest_names[algorithm] == NULL) {
+        PyErr_Format(PyExc_ValueError,
+                     "Unknown algorithm %s, expected crc32c, xxh64 or sha256",
+                     name);
+        return NULL;
+    }
+
+    if (chunk_sectors < 1) {
+        PyErr_SetString(PyExc_ValueError, "chunk_sectors must be at least 1");
+        return NULL;
+    }
+
+    geom = _ped_Geometry2PedGeometry(s);
+    if (geom == NULL) {
+        return NULL;
+    }
+
+    if (algorithm == DIGEST_SHA256) {
+        hashlib = PyImport_ImportModule("hashlib");
+        if (hashlib == NULL) {
+            return NULL;
+        }
+    }
+
+    if (per_chunk) {
+        ret = PyList_New(0);
+        if (ret == NULL) {
+            goto out;
+        }
+    } else if (algorithm == DIGEST_SHA256) {
+        hash = PyObject_CallMethod(hashlib, "sha256", NULL);
+        if (hash == NULL) {
+            goto out;
+        }
+    }
+
+    chunk = (long long) chunk_sectors * geom->dev->sector_size;
+    bufsize = chunk;
+    buf = rawio_buf_get(&bufsize, RAWIO_ALIGN);
+    if (buf == NULL) {
+        PyErr_NoMemory();
+        goto out;
+    }
+
+    offset = geom->start * geom->dev->sector_size;
+    end = offset + geom->length * geom->dev->sector_size;
+
+    Py_BEGIN_ALLOW_THREADS
+    fd = open(geom->dev->path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        rc = errno;
+    } else {
+        posix_fadvise(fd, offset, end - offset, POSIX_FADV_SEQUENTIAL);
+    }
+    Py_END_ALLOW_THREADS
+
+    if (fd == -1) {
+        PyErr_Format(IOException, "Could not open %s: %s", geom->dev->path,
+                     strerror(rc));
+        goto out;
+    }
+
+    digest_xxh64_init(&xxh, 0);
+
+    while (offset < end) {
+        size = end - offset < chunk ? end - offset : chunk;
+
+        Py_BEGIN_ALLOW_THREADS
+        n = rawio_pread(fd, buf, size, offset);
+        if (n == -1) {
+            rc = errno;
+        } else if (n < size) {
+            rc = EIO;
+        } else if (algorithm == DIGEST_CRC32C) {
+            crc = digest_crc32c(per_chunk ? 0 : crc, buf, size);
+            value = crc;
+        } else if (algorithm == DIGEST_XXH64) {
+            if (per_chunk) {
+                digest_xxh64_init(&xxh, 0);
+            }
+
+            digest_xxh64_update(&xxh, buf, size);
+
+            if (per_chunk) {
+                value = digest_xxh64_final(&xxh);
+            }
+        }
+        Py_END_ALLOW_THREADS
+
+        if (rc) {
+            PyErr_Format(IOException, "Could not read from %s: %s",
+                         geom->dev->path, strerror(rc));
+            goto out;
+        }
+
+        if (algorithm == DIGEST_SHA256) {
+            if (per_chunk) {
+                hash = PyObject_CallMethod(hashlib, "sha256", NULL);
+                if (hash == NULL) {
+                    goto out;
+                }
+            }
+
+            if (geometry_digest_update(hash, buf, size) == -1) {
+                goto out;
+            }
+
+            if (per_chunk) {
+                item = PyObject_CallMethod(hash, "hexdigest", NULL);
+                Py_CLEAR(hash);
+            }
+        } else if (per_chunk) {
+            item = geometry_digest_hex(algorithm, value);
+        }
+
+        if (per_chunk) {
+            if (item == NULL || PyList_Append(ret, item) == -1) {
+                goto out;
+            }
+
+            Py_CLEAR(item);
+        }
+
+        offset += size;
+    }
+
+    if (!per_chunk) {
+        if (algorithm == DIGEST_SHA256) {
+            ret = PyObject_CallMethod(hash, "hexdigest", NULL);
+        } else if (algorithm == DIGEST_XXH64) {
+            ret = geometry_digest_hex(algorithm, digest_xxh64_final(&xxh));
+        } else {
+            ret = geometry_digest_hex(algorithm, crc);
+        }
+    }
+
+out:
+    rawio_buf_put(buf, bufsize, RAWIO_ALIGN);
+
+    if (fd != -1) {
+        close(fd);
+    }
+
+    Py_XDECREF(item);
+    Py_XDECREF(hash);
+    Py_XDECREF(hashlib);
+
+    if (PyErr_Occurred()) {
+        Py_XDECREF(ret);
+        return NULL;
+    }
+
+    return ret;
+}
+
 /* vim:tw=78:ts=4:et:sw=4
  */
@@ -28,13 +28,13 @@
 #include "exceptions.h"
 #include "pydevice.h"
 #include "pynatmath.h"
+#include "pystats.h"
 #include "docstrings/pynatmath.h"
 #include "typeobjects/pynatmath.h"
 
 /* _ped.Alignment functions */
 void _ped_Alignment_dealloc(_ped_Alignment *self) {
-    PyObject_GC_UnTrack(self);
-    PyObject_GC_Del(self);
+    Py_TYPE(self)->tp_free(self);
 }
 
 int _ped_Alignment_compare(_ped_Alignment *self, PyObject *obj) {
@@ -87,14 +87,6 @@ PyObject *_ped_Alignment_str(_ped_Alignment *self) {
     return Py_BuildValue("s", ret);
 }
 
-int _ped_Alignment_traverse(_ped_Alignment *self, visitproc visit, void *arg) {
-    return 0;
-}
-
-int _ped_Alignment_clear(_ped_Alignment *self) {
-    return 0;
-}
-
 int _ped_Alignment_init(_ped_Alignment *self, PyObject *args, PyObject *kwds) {
     static char *kwlist[] = {"offset", "grain_size", NULL};
     PedAlignment *alignment = NULL;
@@ -350,5 +342,222 @@ PyObject *py_ped_alignment_is_aligned(PyObject *s, PyObject *args) {
     }
 }
 
+/*
+ * Batch variants of the alignment functions above.  These reimplement the
+ * arithmetic from libparted's natmath.c so a whole buffer of sectors can be
+ * processed with the geometry and alignment read once, no per-sector Python
+ * objects, and straight-line loops the compiler is free to unroll.  Sectors
+ * that cannot be aligned come back as -1 instead of raising ArithmeticError.
+ */
+#define ALIGN_MANY_UP      0
+#define ALIGN_MANY_DOWN    1
+#define ALIGN_MANY_NEAREST 2
+#define ALIGN_MANY_CHECK   3
+
+static inline PedSector natmath_abs_mod(PedSector a, PedSector b) {
+    PedSector r = a % b;
+
+    return (a < 0) ? r + b : r;
+}
+
+static inline PedSector natmath_round_down_to(PedSector sector,
+                                              PedSector grain_size) {
+    return sector - natmath_abs_mod(sector, grain_size);
+}
+
+static inline PedSector natmath_round_up_to(PedSector sector,
+                                            PedSector grain_size) {
+    if (sector % grain_size) {
+        return natmath_round_down_to(sector, grain_size) + grain_size;
+    }
+
+    return sector;
+}
+
+static inline PedSector natmath_closest_inside(PedSector offset,
+                                               PedSector grain_size,
+                                               PedSector start,
+                                               PedSector end,
+                                               PedSector sector) {
+    if (!grain_size) {
+        return (sector == offset && sector >= start && sector <= end) ? sector : -1;
+    }
+
+    if (sector < start) {
+        sector += natmath_round_up_to(start - sector, grain_size);
+    }
+
+    if (sector > end) {
+        sector -= natmath_round_up_to(sector - end, grain_size);
+    }
+
+    return (sector >= start && sector <= end) ? sector : -1;
+}
+
+static inline PedSector natmath_align_up(PedSector offset, PedSector grain_size,
+                                         PedSector start, PedSector end,
+                                         PedSector sector) {
+    PedSector result = offset;
+
+    if (grain_size) {
+        result = natmath_round_up_to(sector - offset, grain_size) + offset;
+    }
+
+    return natmath_closest_inside(offset, grain_size, start, end, result);
+}
+
+static inline PedSector natmath_align_down(PedSector offset,
+                                           PedSector grain_size,
+                                           PedSector start, PedSector end,
+                                           PedSector sector) {
+    PedSector result = offset;
+
+    if (grain_size) {
+        result = natmath_round_down_to(sector - offset, grain_size) + offset;
+    }
+
+    return natmath_closest_inside(offset, grain_size, start, end, result);
+}
+
+static void natmath_align_many(int op, PedSector offset, PedSector grain_size,
+                               PedSector start, PedSector end,
+                               const long long *restrict in,
+                               long long *restrict out, Py_ssize_t count) {
+    PedSector up, down;
+    Py_ssize_t i;
+
+    switch (op) {
+        case ALIGN_MANY_UP:
+            for (i = 0; i < count; i++) {
+                out[i] = natmath_align_up(offset, grain_size, start, end, in[i]);
+            }
+
+            break;
+        case ALIGN_MANY_DOWN:
+            for (i = 0; i < count; i++) {
+                out[i] = natmath_align_down(offset, grain_size, start, end, in[i]);
+            }
+
+            break;
+        case ALIGN_MANY_NEAREST:
+            for (i = 0; i < count; i++) {
+                up = natmath_align_up(offset, grain_size, start, end, in[i]);
+                down = natmath_align_down(offset, grain_size, start, end, in[i]);
+
+                if (up == -1) {
+                    out[i] = down;
+                } else if (down == -1) {
+                    out[i] = up;
+                } else {
+                    out[i] = (llabs(in[i] - up) < llabs(in[i] - down)) ? up : down;
+                }
+            }
+
+            break;
+        case ALIGN_MANY_CHECK:
+            if (grain_size) {
+                for (i = 0; i < count; i++) {
+                    out[i] = in[i] >= start && in[i] <= end &&
+                             (in[i] - offset) % grain_size == 0;
+                }
+            } else {
+                for (i = 0; i < count; i++) {
+                    out[i] = in[i] >= start && in[i] <= end && in[i] == offset;
+                }
+            }
+
+            break;
+    }
+}
+
+static PyObject *py_ped_alignment_many(PyObject *s, PyObject *args, int op) {
+    _ped_Alignment *self = (_ped_Alignment *) s;
+    PyObject *in_geom = NULL, *in_sectors = NULL;
+    PyObject *array_mod = NULL, *zeros = NULL, *ret = NULL;
+    PedGeometry *out_geom = NULL;
+    Py_buffer in_view, out_view;
+    const char *format = NULL;
+
+    if (!PyArg_ParseTuple(args, "O!O", &_ped_Geometry_Type_obj, &in_geom,
+                          &in_sectors)) {
+        return NULL;
+    }
+
+    out_geom = _ped_Geometry2PedGeometry(in_geom);
+    if (out_geom == NULL) {
+        return NULL;
+    }
+
+    if (PyObject_GetBuffer(in_sectors, &in_view,
+                           PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) == -1) {
+        return NULL;
+    }
+
+    /* accept native 64-bit signed integers, e.g. array('q') */
+    format = in_view.format ? in_view.format : "B";
+    if (*format == '@' || *format == '=') {
+        format++;
+    }
+
+    if (in_view.itemsize != sizeof(long long) ||
+        (strcmp(format, "q") && strcmp(format, "l"))) {
+        PyErr_SetString(PyExc_TypeError, "sectors must be a buffer of signed 64-bit integers");
+        PyBuffer_Release(&in_view);
+        return NULL;
+    }
+
+    array_mod = PyImport_ImportModule("array");
+    if (array_mod == NULL) {
+        goto error;
+    }
+
+    zeros = PyBytes_FromStringAndSize(NULL, in_view.len);
+    if (zeros == NULL) {
+        goto error;
+    }
+
+    memset(PyBytes_AS_STRING(zeros), 0, in_view.len);
+
+    ret = PyObject_CallMethod(array_mod, "array", "sO", "q", zeros);
+    if (ret == NULL) {
+        goto error;
+    }
+
+    if (PyObject_GetBuffer(ret, &out_view, PyBUF_C_CONTIGUOUS | PyBUF_WRITABLE) == -1) {
+        Py_CLEAR(ret);
+        goto error;
+    }
+
+    natmath_align_many(op, self->offset, self->grain_size,
+                       out_geom->start, out_geom->end,
+                       (const long long *) in_view.buf,
+                       (long long *) out_view.buf,
+                       in_view.len / in_view.itemsize);
+
+    PyBuffer_Release(&out_view);
+
+error:
+    PyBuffer_Release(&in_view);
+    Py_XDECREF(zeros);
+    Py_XDECREF(array_mod);
+    return ret;
+}
+
+PyObject *py_ped_alignment_align_up_many(PyObject *s, PyObject *args) {
+    return py_ped_alignment_many(s, args, ALIGN_MANY_UP);
+}
+
+PyObject *py_ped_alignment_align_down_many(PyObject *s, PyObject *args) {
+    return py_ped_alignment_many(s, args, ALIGN_MANY_DOWN);
+}
+
+PyObject *py_ped_alignment_align_nearest_many(PyObject *s, PyObject *args) {
+    return py_ped_alignment_many(s, args, ALIGN_MANY_NEAREST);
+}
+
+PyObject *py_ped_alignment_is_aligned_many(PyObject *s, PyObject *args) {
+    return py_ped_alignment_many(s, args, ALIGN_MANY_CHECK);
+}
+
 /* vim:tw=78:ts=4:et:sw=4
  */
@@ -0,0 +1,900 @@
+/*
+ * pystats.c
+ * Opt-in instrumentation of every _ped function and method.  While it is
+ * on, each one is replaced in the module and type dicts by a wrapper that
+ * times the call and notes how many bytes were moved and how many _ped
+ * objects were created meanwhile.  Turning it off puts the originals back,
+ * so that nothing is paid when it is not in use.
+ *
+ * The same switch hooks the device operations libparted does all of its
+ * I/O through, which is where bytes are counted and where the optional
+ * trace of every read, write and sync is recorded.
+ *
+ * Live objects of each _ped type are counted all the time, as tp_alloc and
+ * tp_free of every type go through here, for finding leaks.  The smallest
+ * types are also recycled through freelists here.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ *
+ * This copyrighted material is made available to anyone wishing to use,
+ * modify, copy, or redistribute it subject to the terms and conditions of
+ * the GNU General Public License v.2, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY expressed or implied, including the implied warranties of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.  You should have received a copy of the
+ * GNU General Public License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.  Any Red Hat trademarks that are incorporated in the
+ * source code or documentation are not subject to the GNU General Public
+ * License and may only be used or replicated with the express permission of
+ * Red Hat, Inc.
+ */
+
+#include <Python.h>
+#include <malloc.h>
+#include <parted/parted.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#include "pyconstraint.h"
+#include "pydevice.h"
+#include "pydisk.h"
+#include "pyfilesys.h"
+#include "pygeom.h"
+#include "pynatmath.h"
+#include "pystats.h"
+#include "pytimer.h"
+
+unsigned long long ped_stats_bytes_read = 0;
+unsigned long long ped_stats_bytes_written = 0;
+
+/* Everything collected for one function or method */
+typedef struct {
+    char *name;                 /* e.g. "disk_new" or "Device.read" */
+    unsigned long long calls;
+    unsigned long long total_ns;
+    unsigned long long max_ns;
+    unsigned long long bytes_read;
+    unsigned long long bytes_written;
+    unsigned long long objects;
+    unsigned long long histogram[STATS_BUCKETS];
+} stats_entry;
+
+/* The callable that stands in for an instrumented function or method */
+typedef struct {
+    PyObject_HEAD
+    PyObject *wrapped;          /* the original function or method descriptor */
+    PyObject *name;             /* its key in the module or type dict */
+    PyTypeObject *type;         /* the type it is a method of, or NULL */
+    Py_ssize_t entry;           /* index into stats_entries */
+} stats_wrapper;
+
+static PyTypeObject *stats_types[] = {
+    &_ped_CHSGeometry_Type_obj,
+    &_ped_Device_Type_obj,
+    &_ped_Timer_Type_obj,
+    &_ped_Geometry_Type_obj,
+    &_ped_Alignment_Type_obj,
+    &_ped_Constraint_Type_obj,
+    &_ped_Partition_Type_obj,
+    &_ped_Disk_Type_obj,
+    &_ped_DiskType_Type_obj,
+    &_ped_FileSystemType_Type_obj,
+    &_ped_FileSystem_Type_obj,
+    NULL
+};
+
+#define STATS_NTYPES (sizeof(stats_types) / sizeof(stats_types[0]) - 1)
+
+/* Live objects of each of stats_types, not counting subclasses */
+static Py_ssize_t stats_live[STATS_NTYPES];
+
+/* _ped objects allocated so far */
+static unsigned long long stats_objects = 0;
+
+/* Entries are kept when instrumentation is turned off, so that they can
+ * still be read, and found again by name when it is turned back on. */
+static stats_entry *stats_entries = NULL;
+static Py_ssize_t stats_nentries = 0;
+
+/* The installed wrappers, or NULL when instrumentation is off */
+static PyObject *stats_wrappers = NULL;
+
+/* Whether stats() and the trace are wanted.  The wrappers and hooks are
+ * installed while either one is. */
+static int stats_enabled = 0;
+static int trace_enabled = 0;
+
+/* Name of the innermost instrumented call running in this thread, which
+ * libparted may be doing I/O for with the GIL released. */
+static __thread const char *stats_current = NULL;
+
+/* libparted sends every device access through the dev_ops of the global
+ * ped_architecture.  That is not in the installed headers, so it is
+ * declared here the way libparted/architecture.h does. */
+struct stats_architecture {
+    PedDiskArchOps *disk_ops;
+    PedDeviceArchOps *dev_ops;
+};
+
+extern const struct stats_architecture *ped_architecture;
+
+/* The original is kept after unhooking, an operation that started before
+ * may still be running in a thread that released the GIL. */
+static const struct stats_architecture *stats_saved_arch = NULL;
+static struct stats_architecture stats_arch;
+static PedDeviceArchOps stats_dev_ops;
+
+/* One traced device operation */
+typedef struct {
+    const char *op;             /* "read", "write", "sync" or "sync_fast" */
+    const char *call;           /* stats_entry name, or NULL */
+    PedSector start;
+    PedSector count;
+    unsigned long long ns;
+} trace_record;
+
+#define TRACE_DEFAULT_SIZE 4096
+
+/* The ring the trace is recorded into, oldest record at trace_head */
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static trace_record *trace_ring = NULL;
+static size_t trace_size = 0;
+static size_t trace_head = 0;
+static size_t trace_count = 0;
+static unsigned long long trace_dropped = 0;
+
+static void trace_push(const char *op, PedSector start, PedSector count,
+                       const struct timespec *begin) {
+    struct timespec end;
+    trace_record *rec = NULL;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    pthread_mutex_lock(&trace_lock);
+
+    if (trace_enabled && trace_ring != NULL) {
+        if (trace_count == trace_size) {
+            trace_head = (trace_head + 1) % trace_size;
+            trace_dropped++;
+        } else {
+            trace_count++;
+        }
+
+        rec = &trace_ring[(trace_head + trace_count - 1) % trace_size];
+        rec->op = op;
+        rec->call = stats_current;
+        rec->start = start;
+        rec->count = count;
+        rec->ns = (end.tv_sec - begin->tv_sec) * 1000000000ULL +
+                  end.tv_nsec - begin->tv_nsec;
+    }
+
+    pthread_mutex_unlock(&trace_lock);
+}
+
+static int stats_dev_read(const PedDevice *dev, void *buffer, PedSector start,
+                          PedSector count) {
+    struct timespec begin;
+    int ret;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    ret = stats_saved_arch->dev_ops->read(dev, buffer, start, count);
+
+    if (ret) {
+        ped_stats_count_io(0, count * dev->sector_size);
+    }
+
+    trace_push("read", start, count, &begin);
+    return ret;
+}
+
+static int stats_dev_write(PedDevice *dev, const void *buffer, PedSector start,
+                           PedSector count) {
+    struct timespec begin;
+    int ret;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    ret = stats_saved_arch->dev_ops->write(dev, buffer, start, count);
+
+    if (ret) {
+        ped_stats_count_io(1, count * dev->sector_size);
+    }
+
+    trace_push("write", start, count, &begin);
+    return ret;
+}
+
+static int stats_dev_sync(PedDevice *dev) {
+    struct timespec begin;
+    int ret;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    ret = stats_saved_arch->dev_ops->sync(dev);
+    trace_push("sync", 0, 0, &begin);
+    return ret;
+}
+
+static int stats_dev_sync_fast(PedDevice *dev) {
+    struct timespec begin;
+    int ret;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    ret = stats_saved_arch->dev_ops->sync_fast(dev);
+    trace_push("sync_fast", 0, 0, &begin);
+    return ret;
+}
+
+/* Point libparted at a copy of its device operations with the I/O ones
+ * timed.  The rest are passed through untouched. */
+static void stats_hook_io(void) {
+    if (ped_architecture == NULL || ped_architecture == &stats_arch) {
+        return;
+    }
+
+    stats_saved_arch = ped_architecture;
+    stats_dev_ops = *stats_saved_arch->dev_ops;
+    stats_dev_ops.read = stats_dev_read;
+    stats_dev_ops.write = stats_dev_write;
+    stats_dev_ops.sync = stats_dev_sync;
+    stats_dev_ops.sync_fast = stats_dev_sync_fast;
+
+    stats_arch.disk_ops = stats_saved_arch->disk_ops;
+    stats_arch.dev_ops = &stats_dev_ops;
+    ped_architecture = &stats_arch;
+}
+
+static void stats_unhook_io(void) {
+    if (ped_architecture == &stats_arch) {
+        ped_architecture = stats_saved_arch;
+    }
+}
+
+static size_t stats_type_index(PyTypeObject *type) {
+    size_t i;
+
+    for (i = 0; i < STATS_NTYPES; i++) {
+        if (stats_types[i] == type) {
+            break;
+        }
+    }
+
+    return i;
+}
+
+/* Objects of the small types that partition walks create and drop by the
+ * thousand are kept here when freed and handed out again, instead of going
+ * back to the allocator each time. */
+#define FREELIST_SIZE 256
+
+typedef struct {
+    PyTypeObject *type;
+    int count;
+    PyObject *items[FREELIST_SIZE];
+} ped_freelist;
+
+static ped_freelist freelists[] = {
+    { &_ped_CHSGeometry_Type_obj },
+    { &_ped_Geometry_Type_obj },
+    { &_ped_Alignment_Type_obj },
+};
+
+#define FREELIST_NTYPES (sizeof(freelists) / sizeof(freelists[0]))
+
+static ped_freelist *freelist_find(PyTypeObject *type) {
+    size_t i;
+
+    for (i = 0; i < FREELIST_NTYPES; i++) {
+        if (freelists[i].type == type) {
+            return &freelists[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* tp_alloc and tp_free of every _ped type, which keep the object counts
+ * live_objects() and the instrumentation report. */
+PyObject *_ped_object_alloc(PyTypeObject *type, Py_ssize_t nitems) {
+    ped_freelist *freelist = freelist_find(type);
+    PyObject *ret = NULL;
+    size_t i;
+
+    if (freelist != NULL && freelist->count > 0) {
+        /* Set up the way PyType_GenericAlloc() would. */
+        ret = freelist->items[--freelist->count];
+        memset(ret, 0, type->tp_basicsize);
+        PyObject_Init(ret, type);
+
+        if (PyType_IS_GC(type)) {
+            PyObject_GC_Track(ret);
+        }
+    } else {
+        ret = PyType_GenericAlloc(type, nitems);
+    }
+
+    if (ret != NULL) {
+        stats_objects++;
+
+        i = stats_type_index(type);
+        if (i < STATS_NTYPES) {
+            stats_live[i]++;
+        }
+    }
+
+    return ret;
+}
+
+void _ped_object_free(void *self) {
+    PyTypeObject *type = Py_TYPE((PyObject *) self);
+    ped_freelist *freelist = freelist_find(type);
+    size_t i = stats_type_index(type);
+
+    if (i < STATS_NTYPES) {
+        stats_live[i]--;
+    }
+
+    if (freelist != NULL && freelist->count < FREELIST_SIZE) {
+        freelist->items[freelist->count++] = self;
+    } else if (PyType_IS_GC(type)) {
+        PyObject_GC_Del(self);
+    } else {
+        PyObject_Del(self);
+    }
+}
+
+static PyObject *stats_wrapper_call(stats_wrapper *self, PyObject *args,
+                                    PyObject *kwds) {
+    struct timespec start, end;
+    unsigned long long read, written, objects, ns;
+    stats_entry *entry = NULL;
+    PyObject *ret = NULL;
+    const char *outer = stats_current;
+    int bucket;
+
+    read = __atomic_load_n(&ped_stats_bytes_read, __ATOMIC_RELAXED);
+    written = __atomic_load_n(&ped_stats_bytes_written, __ATOMIC_RELAXED);
+    objects = stats_objects;
+
+    stats_current = stats_entries[self->entry].name;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ret = PyObject_Call(self->wrapped, args, kwds);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    stats_current = outer;
+
+    if (!stats_enabled) {
+        return ret;
+    }
+
+    ns = (end.tv_sec - start.tv_sec) * 1000000000ULL +
+         end.tv_nsec - start.tv_nsec;
+
+    /* Looked up only now, the call may have added entries. */
+    entry = &stats_entries[self->entry];
+    entry->calls++;
+    entry->total_ns += ns;
+    entry->bytes_read += __atomic_load_n(&ped_stats_bytes_read,
+                                         __ATOMIC_RELAXED) - read;
+    entry->bytes_written += __atomic_load_n(&ped_stats_bytes_written,
+                                            __ATOMIC_RELAXED) - written;
+    entry->objects += stats_objects - objects;
+
+    if (ns > entry->max_ns) {
+        entry->max_ns = ns;
+    }
+
+    for (bucket = 0; bucket < STATS_BUCKETS - 1; bucket++) {
+        if (ns < (1000ULL << bucket)) {
+            break;
+        }
+    }
+
+    entry->histogram[bucket]++;
+    return ret;
+}
+
+/* Bind like the method descriptor being stood in for. */
+static PyObject *stats_wrapper_get(PyObject *self, PyObject *obj,
+                                   PyObject *type) {
+    if (obj == NULL || obj == Py_None || ((stats_wrapper *) self)->type == NULL) {
+        Py_INCREF(self);
+        return self;
+    }
+
+#if PY_MAJOR_VERSION >= 3
+    return PyMethod_New(self, obj);
+#else
+    return PyMethod_New(self, obj, type);
+#endif
+}
+
+/* Look like the wrapped callable to help() and friends. */
+static PyObject *stats_wrapper_getattro(PyObject *self, PyObject *name) {
+    PyObject *ret = PyObject_GetAttr(((stats_wrapper *) self)->wrapped, name);
+
+    if (ret == NULL && PyErr_ExceptionMatches(PyExc_AttributeError)) {
+        PyErr_Clear();
+        ret = PyObject_GenericGetAttr(self, name);
+    }
+
+    return ret;
+}
+
+static PyObject *stats_wrapper_repr(stats_wrapper *self) {
+    return PyUnicode_FromFormat("<instrumented %R>", self->wrapped);
+}
+
+static void stats_wrapper_dealloc(stats_wrapper *self) {
+    Py_XDECREF(self->wrapped);
+    Py_XDECREF(self->name);
+    PyObject_Del(self);
+}
+
+static PyTypeObject stats_wrapper_Type_obj = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "_ped.InstrumentedCall",
+    .tp_basicsize = sizeof(stats_wrapper),
+    .tp_dealloc = (destructor) stats_wrapper_dealloc,
+    .tp_repr = (reprfunc) stats_wrapper_repr,
+    .tp_call = (ternaryfunc) stats_wrapper_call,
+    .tp_getattro = stats_wrapper_getattro,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_descr_get = stats_wrapper_get,
+};
+
+/* Return the index of the entry called name, adding it if needed. */
+static Py_ssize_t stats_entry_find(const char *name) {
+    stats_entry *entries = NULL;
+    Py_ssize_t i;
+
+    for (i = 0; i < stats_nentries; i++) {
+        if (!strcmp(stats_entries[i].name, name)) {
+            return i;
+        }
+    }
+
+    entries = realloc(stats_entries, (stats_nentries + 1) * sizeof(*entries));
+    if (entries == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    stats_entries = entries;
+    memset(&stats_entries[i], 0, sizeof(stats_entries[i]));
+
+    stats_entries[i].name = strdup(name);
+    if (stats_entries[i].name == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    return stats_nentries++;
+}
+
+/* Replace dict[name], which holds wrapped, by a wrapper. */
+static int stats_wrap(PyObject *dict, PyTypeObject *type, PyObject *name,
+                      PyObject *wrapped) {
+    stats_wrapper *wrapper = NULL;
+    PyObject *label = NULL;
+    Py_ssize_t entry;
+    const char *type_name;
+    int ret = -1;
+
+    if (type != NULL) {
+        type_name = strrchr(type->tp_name, '.');
+        label = PyUnicode_FromFormat("%s.%U",
+                                     type_name ? type_name + 1 : type->tp_name,
+                                     name);
+    } else {
+        label = PyObject_Str(name);
+    }
+
+    if (label == NULL) {
+        return -1;
+    }
+
+    entry = stats_entry_find(PyUnicode_AsUTF8(label));
+    Py_DECREF(label);
+
+    if (entry == -1) {
+        return -1;
+    }
+
+    wrapper = PyObject_New(stats_wrapper, &stats_wrapper_Type_obj);
+    if (wrapper == NULL) {
+        return -1;
+    }
+
+    Py_INCREF(wrapped);
+    wrapper->wrapped = wrapped;
+    Py_INCREF(name);
+    wrapper->name = name;
+    wrapper->type = type;
+    wrapper->entry = entry;
+
+    if (PyList_Append(stats_wrappers, (PyObject *) wrapper) == 0 &&
+        PyDict_SetItem(dict, name, (PyObject *) wrapper) == 0) {
+        ret = 0;
+    }
+
+    Py_DECREF(wrapper);
+    return ret;
+}
+
+static int stats_install(PyObject *module) {
+    PyObject *items = NULL, *name = NULL, *value = NULL, *descr = NULL;
+    PyTypeObject *type = NULL;
+    PyMethodDef *def = NULL;
+    Py_ssize_t i;
+    size_t t;
+
+    stats_wrappers = PyList_New(0);
+    if (stats_wrappers == NULL) {
+        return -1;
+    }
+
+    /* Module functions, leaving out the ones reading these statistics
+     * and the trace. */
+    items = PyDict_Items(PyModule_GetDict(module));
+    if (items == NULL) {
+        return -1;
+    }
+
+    for (i = 0; i < PyList_GET_SIZE(items); i++) {
+        name = PyTuple_GET_ITEM(PyList_GET_ITEM(items, i), 0);
+        value = PyTuple_GET_ITEM(PyList_GET_ITEM(items, i), 1);
+
+        if (!PyCFunction_Check(value) ||
+            !strncmp(PyUnicode_AsUTF8(name), "stats", 5) ||
+            !strncmp(PyUnicode_AsUTF8(name), "trace", 5)) {
+            continue;
+        }
+
+        if (stats_wrap(PyModule_GetDict(module), NULL, name, value) == -1) {
+            Py_DECREF(items);
+            return -1;
+        }
+    }
+
+    Py_DECREF(items);
+
+    /* Methods of the _ped types. */
+    for (t = 0; t < STATS_NTYPES; t++) {
+        type = stats_types[t];
+
+        for (def = type->tp_methods; def && def->ml_name; def++) {
+            if (def->ml_flags & (METH_CLASS | METH_STATIC)) {
+                continue;
+            }
+
+            descr = PyDict_GetItemString(type->tp_dict, def->ml_name);
+            if (descr == NULL) {
+                continue;
+            }
+
+            name = PyUnicode_FromString(def->ml_name);
+            if (name == NULL || stats_wrap(type->tp_dict, type, name,
+                                           descr) == -1) {
+                Py_XDECREF(name);
+                PyType_Modified(type);
+                return -1;
+            }
+
+            Py_DECREF(name);
+        }
+
+        PyType_Modified(type);
+    }
+
+    stats_hook_io();
+    return 0;
+}
+
+static void stats_uninstall(PyObject *module) {
+    stats_wrapper *wrapper = NULL;
+    PyObject *dict = NULL;
+    Py_ssize_t i;
+    size_t t;
+
+    if (stats_wrappers == NULL) {
+        return;
+    }
+
+    stats_unhook_io();
+
+    for (i = 0; i < PyList_GET_SIZE(stats_wrappers); i++) {
+        wrapper = (stats_wrapper *) PyList_GET_ITEM(stats_wrappers, i);
+        dict = wrapper->type ? wrapper->type->tp_dict : PyModule_GetDict(module);
+
+        if (PyDict_GetItem(dict, wrapper->name) == (PyObject *) wrapper) {
+            PyDict_SetItem(dict, wrapper->name, wrapper->wrapped);
+        }
+    }
+
+    for (t = 0; t < STATS_NTYPES; t++) {
+        PyType_Modified(stats_types[t]);
+    }
+
+    Py_CLEAR(stats_wrappers);
+}
+
+/* Set *flag to enable, installing or removing the wrappers and hooks if
+ * this turns the first one on or the last one off. */
+static int stats_switch(int *flag, int enable) {
+    PyObject *module = NULL;
+    int was_installed = stats_wrappers != NULL;
+    int old = *flag;
+
+    if (PyType_Ready(&stats_wrapper_Type_obj) < 0) {
+        return -1;
+    }
+
+    module = PyImport_ImportModule("_ped");
+    if (module == NULL) {
+        return -1;
+    }
+
+    *flag = enable;
+
+    if ((stats_enabled || trace_enabled) && !was_installed) {
+        if (stats_install(module) == -1) {
+            stats_uninstall(module);
+            *flag = old;
+            Py_DECREF(module);
+            return -1;
+        }
+    } else if (!stats_enabled && !trace_enabled && was_installed) {
+        stats_uninstall(module);
+    }
+
+    Py_DECREF(module);
+    return 0;
+}
+
+PyObject *py_ped_stats_enable(PyObject *s, PyObject *args) {
+    PyObject *in_enable = NULL;
+    int enable, was_enabled = stats_enabled;
+
+    if (!PyArg_ParseTuple(args, "|O", &in_enable)) {
+        return NULL;
+    }
+
+    if (in_enable != NULL) {
+        enable = PyObject_IsTrue(in_enable);
+        if (enable == -1) {
+            return NULL;
+        }
+
+        if (stats_switch(&stats_enabled, enable) == -1) {
+            return NULL;
+        }
+    }
+
+    if (was_enabled) {
+        Py_RETURN_TRUE;
+    } else {
+        Py_RETURN_FALSE;
+    }
+}
+
+PyObject *py_ped_stats(PyObject *s, PyObject *args) {
+    PyObject *ret = NULL, *item = NULL, *histogram = NULL;
+    stats_entry *entry = NULL;
+    Py_ssize_t i;
+    int b;
+
+    ret = PyDict_New();
+    if (ret == NULL) {
+        return NULL;
+    }
+
+    for (i = 0; i < stats_nentries; i++) {
+        entry = &stats_entries[i];
+
+        if (entry->calls == 0) {
+            continue;
+        }
+
+        histogram = PyTuple_New(STATS_BUCKETS);
+        if (histogram == NULL) {
+            goto error;
+        }
+
+        for (b = 0; b < STATS_BUCKETS; b++) {
+            PyTuple_SET_ITEM(histogram, b,
+                             PyLong_FromUnsignedLongLong(entry->histogram[b]));
+        }
+
+        item = Py_BuildValue("{s:K,s:d,s:d,s:K,s:K,s:K,s:N}",
+                             "calls", entry->calls,
+                             "total", entry->total_ns / 1e9,
+                             "max", entry->max_ns / 1e9,
+                             "bytes_read", entry->bytes_read,
+                             "bytes_written", entry->bytes_written,
+                             "objects", entry->objects,
+                             "histogram", histogram);
+        if (item == NULL) {
+            goto error;
+        }
+
+        if (PyDict_SetItemString(ret, entry->name, item) == -1) {
+            Py_DECREF(item);
+            goto error;
+        }
+
+        Py_DECREF(item);
+    }
+
+    return ret;
+
+error:
+    Py_DECREF(ret);
+    return NULL;
+}
+
+PyObject *py_ped_stats_reset(PyObject *s, PyObject *args) {
+    Py_ssize_t i;
+    char *name = NULL;
+
+    for (i = 0; i < stats_nentries; i++) {
+        name = stats_entries[i].name;
+        memset(&stats_entries[i], 0, sizeof(stats_entries[i]));
+        stats_entries[i].name = name;
+    }
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+PyObject *py_ped_trace_enable(PyObject *s, PyObject *args) {
+    PyObject *in_enable = NULL;
+    Py_ssize_t size = TRACE_DEFAULT_SIZE;
+    trace_record *ring = NULL;
+    int enable, was_enabled = trace_enabled;
+
+    if (!PyArg_ParseTuple(args, "|On", &in_enable, &size)) {
+        return NULL;
+    }
+
+    if (size <= 0) {
+        PyErr_SetString(PyExc_ValueError, "size must be positive.");
+        return NULL;
+    }
+
+    if (in_enable != NULL) {
+        enable = PyObject_IsTrue(in_enable);
+        if (enable == -1) {
+            return NULL;
+        }
+
+        /* Turning it on starts from an empty ring of the given size. */
+        if (enable) {
+            ring = calloc(size, sizeof(*ring));
+            if (ring == NULL) {
+                return PyErr_NoMemory();
+            }
+
+            pthread_mutex_lock(&trace_lock);
+            free(trace_ring);
+            trace_ring = ring;
+            trace_size = size;
+            trace_head = trace_count = 0;
+            trace_dropped = 0;
+            pthread_mutex_unlock(&trace_lock);
+        }
+
+        if (stats_switch(&trace_enabled, enable) == -1) {
+            return NULL;
+        }
+    }
+
+    if (was_enabled) {
+        Py_RETURN_TRUE;
+    } else {
+        Py_RETURN_FALSE;
+    }
+}
+
+PyObject *py_ped_trace_drain(PyObject *s, PyObject *args) {
+    PyObject *ret = NULL, *item = NULL;
+    trace_record *records = NULL;
+    size_t i, count;
+
+    /* Copy out under the lock, build the list without it. */
+    pthread_mutex_lock(&trace_lock);
+    count = trace_count;
+
+    if (count) {
+        records = malloc(count * sizeof(*records));
+        if (records == NULL) {
+            pthread_mutex_unlock(&trace_lock);
+            return PyErr_NoMemory();
+        }
+
+        for (i = 0; i < count; i++) {
+            records[i] = trace_ring[(trace_head + i) % trace_size];
+        }
+
+        trace_head = trace_count = 0;
+    }
+
+    pthread_mutex_unlock(&trace_lock);
+
+    ret = PyList_New(count);
+    if (ret == NULL) {
+        free(records);
+        return NULL;
+    }
+
+    for (i = 0; i < count; i++) {
+        item = Py_BuildValue("(sLLdz)", records[i].op, records[i].start,
+                             records[i].count, records[i].ns / 1e9,
+                             records[i].call);
+        if (item == NULL) {
+            Py_DECREF(ret);
+            free(records);
+            return NULL;
+        }
+
+        PyList_SET_ITEM(ret, i, item);
+    }
+
+    free(records);
+    return ret;
+}
+
+PyObject *py_ped_trace_info(PyObject *s, PyObject *args) {
+    PyObject *ret = NULL;
+
+    pthread_mutex_lock(&trace_lock);
+    ret = Py_BuildValue("{s:O,s:n,s:n,s:K}",
+                        "enabled", trace_enabled ? Py_True : Py_False,
+                        "size", (Py_ssize_t) trace_size,
+                        "pending", (Py_ssize_t) trace_count,
+                        "dropped", trace_dropped);
+    pthread_mutex_unlock(&trace_lock);
+
+    return ret;
+}
+
+PyObject *py_ped_live_objects(PyObject *s, PyObject *args) {
+    PyObject *ret = NULL, *count = NULL;
+    const char *name = NULL;
+    size_t t;
+
+    ret = PyDict_New();
+    if (ret == NULL) {
+        return NULL;
+    }
+
+    for (t = 0; t < STATS_NTYPES; t++) {
+        name = strrchr(stats_types[t]->tp_name, '.');
+        count = PyLong_FromSsize_t(stats_live[t]);
+
+        if (count == NULL ||
+            PyDict_SetItemString(ret, name ? name + 1 : stats_types[t]->tp_name,
+                                 count) == -1) {
+            Py_XDECREF(count);
+            Py_DECREF(ret);
+            return NULL;
+        }
+
+        Py_DECREF(count);
+    }
+
+    return ret;
+}
+
+PyObject *py_ped_native_memory(PyObject *s, PyObject *args) {
+#if __GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 info = mallinfo2();
+#else
+    struct mallinfo info = mallinfo();
+#endif
+
+    return PyLong_FromSize_t((size_t) info.uordblks + (size_t) info.hblkhd);
+}
+
+/* vim:tw=78:ts=4:et:sw=4
+ */
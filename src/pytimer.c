@@ -26,6 +26,7 @@
 
 #include "convert.h"
 #include "exceptions.h"
+#include "pystats.h"
 #include "pytimer.h"
 #include "typeobjects/pytimer.h"
 
@@ -33,7 +34,7 @@
 void _ped_Timer_dealloc(_ped_Timer *self) {
     PyObject_GC_UnTrack(self);
     free(self->state_name);
-    PyObject_GC_Del(self);
+    Py_TYPE(self)->tp_free(self);
 }
 
 int _ped_Timer_compare(_ped_Timer *self, PyObject *obj) {
@@ -341,5 +342,94 @@ PyObject *py_ped_timer_set_state_name(PyObject *s, PyObject *args) {
     return Py_None;
 }
 
+/*
+ * Progress reporting for the native bulk operations.  _ped.Timer objects
+ * cannot be created from Python, so those operations take an optional
+ * callable instead and drive a libparted PedTimer themselves.  Every update
+ * hands the callable a _ped.Timer snapshot with frac, start, now,
+ * predicted_end and state_name filled in by libparted.  Updates are made
+ * with the GIL held, between chunks of work done without it.
+ */
+static void progress_timer_handler(PedTimer *timer, void *context) {
+    PyObject *callback = context;
+    _ped_Timer *snapshot = NULL;
+    PyObject *result = NULL;
+
+    /* libparted touches the timer while creating it, before there is a
+     * state name, and once the callable has raised there is no point in
+     * calling it again. */
+    if (timer->state_name == NULL || PyErr_Occurred()) {
+        return;
+    }
+
+    snapshot = PedTimer2_ped_Timer(timer);
+    if (snapshot == NULL) {
+        return;
+    }
+
+    result = PyObject_CallFunctionObjArgs(callback, (PyObject *) snapshot,
+                                          NULL);
+    Py_DECREF(snapshot);
+    Py_XDECREF(result);
+}
+
+/* Check a progress argument.  Returns 1 if it is a callable, 0 if it is
+ * NULL or None, and -1 with TypeError set otherwise. */
+int progress_timer_check(PyObject *callback) {
+    if (callback == NULL || callback == Py_None) {
+        return 0;
+    }
+
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "progress must be callable or None");
+        return -1;
+    }
+
+    return 1;
+}
+
+/* Create a timer reporting to callback, which must have passed
+ * progress_timer_check().  state_name is not copied, so it should be a
+ * string constant.  Returns NULL without an exception set when there is
+ * nothing to report to. */
+PedTimer *progress_timer_new(PyObject *callback, const char *state_name) {
+    PedTimer *timer = NULL;
+
+    if (callback == NULL || callback == Py_None) {
+        return NULL;
+    }
+
+    timer = ped_timer_new(progress_timer_handler, callback);
+    if (timer == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+
+    /* This also makes the first report, with frac 0. */
+    ped_timer_set_state_name(timer, state_name);
+    if (PyErr_Occurred()) {
+        ped_timer_destroy(timer);
+        return NULL;
+    }
+
+    return timer;
+}
+
+/* Report frac of the work as done.  Returns -1 if the callable raised. */
+int progress_timer_update(PedTimer *timer, float frac) {
+    if (timer == NULL) {
+        return 0;
+    }
+
+    ped_timer_update(timer, frac);
+    return PyErr_Occurred() ? -1 : 0;
+}
+
+void progress_timer_destroy(PedTimer *timer) {
+    if (timer != NULL) {
+        ped_timer_destroy(timer);
+    }
+}
+
 /* vim:tw=78:ts=4:et:sw=4
  */
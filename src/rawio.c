@@ -0,0 +1,612 @@
+/*
+ * rawio.c
+ * Plain file descriptor I/O for the native code that runs without the GIL.
+ * libparted's own I/O goes through the shared PedDevice and reports errors
+ * through the exception handler, which calls back into Python, so anything
+ * that reads or writes a device with the GIL released uses these instead.
+ * None of these functions touch libparted or the Python API.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ *
+ * This copyrighted material is made available to anyone wishing to use,
+ * modify, copy, or redistribute it subject to the terms and conditions of
+ * the GNU General Public License v.2, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY expressed or implied, including the implied warranties of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.  You should have received a copy of the
+ * GNU General Public License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.  Any Red Hat trademarks that are incorporated in the
+ * source code or documentation are not subject to the GNU General Public
+ * License and may only be used or replicated with the express permission of
+ * Red Hat, Inc.
+ */
+
+#include <Python.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/falloc.h>
+#include <linux/fs.h>
+
+#include "pystats.h"
+#include "rawio.h"
+
+/* Read up to size bytes at offset, retrying interrupted and short reads.
+ * Returns the number of bytes read, which is less than size only at the end
+ * of the file, or -1 with errno set. */
+ssize_t rawio_pread(int fd, void *buf, size_t size, long long offset) {
+    ssize_t n;
+    size_t done = 0;
+
+    while (done < size) {
+        n = pread(fd, (char *) buf + done, size - done, offset + done);
+
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return -1;
+        } else if (n == 0) {
+            break;
+        }
+
+        ped_stats_count_io(0, n);
+        done += n;
+    }
+
+    return done;
+}
+
+/* Write all size bytes at offset, retrying interrupted and short writes.
+ * Returns 0 or -1 with errno set. */
+int rawio_pwrite(int fd, const void *buf, size_t size, long long offset) {
+    ssize_t n;
+    size_t done = 0;
+
+    while (done < size) {
+        n = pwrite(fd, (const char *) buf + done, size - done, offset + done);
+
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return -1;
+        }
+
+        ped_stats_count_io(1, n);
+        done += n;
+    }
+
+    return 0;
+}
+
+static int rawio_write_zeros(int fd, long long offset, long long size) {
+    void *zeros = NULL;
+    size_t n;
+    int rc = 0;
+
+    if (posix_memalign(&zeros, RAWIO_ALIGN, RAWIO_ZERO_BUF)) {
+        return ENOMEM;
+    }
+
+    memset(zeros, 0, RAWIO_ZERO_BUF);
+
+    while (size > 0) {
+        n = size < RAWIO_ZERO_BUF ? size : RAWIO_ZERO_BUF;
+
+        if (rawio_pwrite(fd, zeros, n, offset) == -1) {
+            rc = errno;
+            break;
+        }
+
+        offset += n;
+        size -= n;
+    }
+
+    free(zeros);
+    return rc;
+}
+
+/* Errors meaning "this file or device cannot do that", as opposed to an
+ * actual I/O failure. */
+static int rawio_unsupported(int err) {
+    return err == EOPNOTSUPP || err == ENOTTY || err == EINVAL ||
+           err == ENOSYS;
+}
+
+/* Zero (RAWIO_ZERO) or discard (RAWIO_DISCARD) size bytes at offset on fd.
+ * Block devices use BLKZEROOUT or BLKDISCARD and files use fallocate(2).
+ * When zeroing a file that cannot zero a range, a punched hole stands in;
+ * failing that, or on a block device without BLKZEROOUT, zeros are written
+ * out in large aligned chunks.  Discarding has no fallback.
+ *
+ * *method is the method to start with, RAWIO_CLEAR_NATIVE for a fresh
+ * range, and is updated to the one that worked, so a caller going through a
+ * large range in steps only tries the unsupported ones once.  Returns 0,
+ * ENOTSUP if discarding is not supported, or an errno value. */
+int rawio_clear(int fd, int op, long long offset, long long size,
+                int *method) {
+    unsigned long long range[2];
+    struct stat st;
+    int blk, rc;
+
+    if (fstat(fd, &st) == -1) {
+        return errno;
+    }
+
+    blk = S_ISBLK(st.st_mode);
+
+    if (*method == RAWIO_CLEAR_NATIVE) {
+        if (blk) {
+            range[0] = offset;
+            range[1] = size;
+            rc = ioctl(fd, op == RAWIO_ZERO ? BLKZEROOUT : BLKDISCARD, range);
+        } else {
+            rc = fallocate(fd, FALLOC_FL_KEEP_SIZE |
+                           (op == RAWIO_ZERO ? FALLOC_FL_ZERO_RANGE
+                                             : FALLOC_FL_PUNCH_HOLE),
+                           offset, size);
+        }
+
+        if (rc == 0) {
+            return 0;
+        } else if (!rawio_unsupported(errno)) {
+            return errno;
+        }
+
+        *method = blk ? RAWIO_CLEAR_WRITE : RAWIO_CLEAR_PUNCH;
+    }
+
+    if (op == RAWIO_DISCARD) {
+        return ENOTSUP;
+    }
+
+    if (*method == RAWIO_CLEAR_PUNCH) {
+        if (fallocate(fd, FALLOC_FL_KEEP_SIZE | FALLOC_FL_PUNCH_HOLE,
+                      offset, size) == 0) {
+            return 0;
+        } else if (!rawio_unsupported(errno)) {
+            return errno;
+        }
+
+        *method = RAWIO_CLEAR_WRITE;
+    }
+
+    return rawio_write_zeros(fd, offset, size);
+}
+
+/* Open path with O_DIRECT so that I/O bypasses the page cache.  Some
+ * filesystems (tmpfs, for one) refuse O_DIRECT; the file is then opened
+ * normally and *direct is set to 0, and the caller should give back what it
+ * touched with rawio_drop_cache().  Returns the descriptor, or -1 with errno
+ * set. */
+int rawio_open_direct(const char *path, int flags, int *direct) {
+    int fd;
+
+    fd = open(path, flags | O_DIRECT | O_CLOEXEC);
+    if (fd != -1 || errno != EINVAL) {
+        *direct = 1;
+        return fd;
+    }
+
+    *direct = 0;
+    return open(path, flags | O_CLOEXEC);
+}
+
+/* Drop size bytes at offset from the page cache after buffered I/O, writing
+ * them back first if dirty is set.  Returns 0 or an errno value. */
+int rawio_drop_cache(int fd, long long offset, long long size, int dirty) {
+    if (dirty && fdatasync(fd) == -1) {
+        return errno;
+    }
+
+    return posix_fadvise(fd, offset, size, POSIX_FADV_DONTNEED);
+}
+
+/* Aligned buffers handed back with rawio_buf_put() are kept here, so that a
+ * scan reading the same amount over and over does not allocate every time. */
+typedef struct {
+    void *buf;
+    size_t size;
+    size_t align;
+} rawio_pool_slot;
+
+static rawio_pool_slot rawio_pool[RAWIO_POOL_SLOTS];
+static pthread_mutex_t rawio_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Return a buffer of at least *size bytes aligned to align, a power of two.
+ * *size is set to the real size of the buffer, which goes back to the pool
+ * with rawio_buf_put().  Returns NULL if out of memory. */
+void *rawio_buf_get(size_t *size, size_t align) {
+    size_t want = RAWIO_ALIGN;
+    void *buf = NULL;
+    int i, best = -1;
+
+    if (align < sizeof(void *)) {
+        align = sizeof(void *);
+    }
+
+    /* Round small requests up to a power of two so that they share slots. */
+    if (*size <= RAWIO_POOL_MAX) {
+        while (want < *size) {
+            want <<= 1;
+        }
+    } else {
+        want = (*size + align - 1) & ~(align - 1);
+    }
+
+    pthread_mutex_lock(&rawio_pool_lock);
+
+    for (i = 0; i < RAWIO_POOL_SLOTS; i++) {
+        if (rawio_pool[i].buf != NULL && rawio_pool[i].size >= want &&
+            rawio_pool[i].align >= align &&
+            (best == -1 || rawio_pool[i].size < rawio_pool[best].size)) {
+            best = i;
+        }
+    }
+
+    if (best != -1) {
+        buf = rawio_pool[best].buf;
+        want = rawio_pool[best].size;
+        rawio_pool[best].buf = NULL;
+    }
+
+    pthread_mutex_unlock(&rawio_pool_lock);
+
+    if (buf == NULL && posix_memalign(&buf, align, want) != 0) {
+        return NULL;
+    }
+
+    *size = want;
+    return buf;
+}
+
+/* Give back a buffer from rawio_buf_get(), with the size and alignment it
+ * was returned with. */
+void rawio_buf_put(void *buf, size_t size, size_t align) {
+    int i;
+
+    if (buf == NULL) {
+        return;
+    }
+
+    if (size <= RAWIO_POOL_MAX) {
+        pthread_mutex_lock(&rawio_pool_lock);
+
+        for (i = 0; i < RAWIO_POOL_SLOTS; i++) {
+            if (rawio_pool[i].buf == NULL) {
+                rawio_pool[i].buf = buf;
+                rawio_pool[i].size = size;
+                rawio_pool[i].align = align < sizeof(void *) ? sizeof(void *) : align;
+                buf = NULL;
+                break;
+            }
+        }
+
+        pthread_mutex_unlock(&rawio_pool_lock);
+    }
+
+    free(buf);
+}
+
+/* Whether all size bytes of buf are zero. */
+int rawio_is_zero(const unsigned char *buf, size_t size) {
+    if (size == 0) {
+        return 1;
+    }
+
+    /* If the first byte is zero and every byte equals the one after it,
+     * they are all zero; memcmp() does the comparing a word at a time. */
+    return buf[0] == 0 && !memcmp(buf, buf + 1, size - 1);
+}
+
+/*
+ * Bulk copying.  Workers take chunks from the job in order, so with two or
+ * more of them one is reading the next chunk while another is writing the
+ * previous one, which keeps both sides of the copy busy.  When both sides
+ * are regular files, copy_file_range(2) lets the kernel (or the filesystem,
+ * or the NFS server) do the copy instead.  With job->sparse set, chunks of
+ * zeros become holes in the destination rather than being written.
+ */
+void rawio_copy_init(rawio_copy_job *job, int src_fd, long long src_offset,
+                     int dst_fd, long long dst_offset, long long size,
+                     size_t chunk) {
+    struct stat src_st, dst_st;
+
+    memset(job, 0, sizeof(*job));
+    job->src_fd = src_fd;
+    job->src_offset = src_offset;
+    job->dst_fd = dst_fd;
+    job->dst_offset = dst_offset;
+    job->size = size;
+    job->chunk = chunk;
+
+    if (fstat(src_fd, &src_st) == 0 && fstat(dst_fd, &dst_st) == 0 &&
+        S_ISREG(dst_st.st_mode)) {
+        job->flags |= RAWIO_COPY_SPARSE;
+#ifdef __NR_copy_file_range
+        if (S_ISREG(src_st.st_mode)) {
+            job->flags |= RAWIO_COPY_RANGE;
+        }
+#endif
+    }
+
+    pthread_mutex_init(&job->lock, NULL);
+}
+
+void rawio_copy_destroy(rawio_copy_job *job) {
+    pthread_mutex_destroy(&job->lock);
+}
+
+static int rawio_copy_range(rawio_copy_job *job, long long offset,
+                            size_t size) {
+#ifdef __NR_copy_file_range
+    loff_t in = job->src_offset + offset, out = job->dst_offset + offset;
+    long n;
+
+    while (size > 0) {
+        n = syscall(__NR_copy_file_range, job->src_fd, &in, job->dst_fd, &out,
+                    size, 0);
+
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return errno;
+        } else if (n == 0) {
+            return EIO;
+        }
+
+        size -= n;
+    }
+
+    return 0;
+#else
+    return ENOSYS;
+#endif
+}
+
+/* Copy one chunk.  flags holds the job's flags as of when the chunk was
+ * handed out, and any that turn out not to work are cleared from it. */
+static int rawio_copy_chunk(rawio_copy_job *job, unsigned char *buf,
+                            long long offset, size_t size, int *flags) {
+    long long dst = job->dst_offset + offset;
+    ssize_t got;
+    int rc;
+
+    if (*flags & RAWIO_COPY_RANGE) {
+        rc = rawio_copy_range(job, offset, size);
+        if (rc == 0) {
+            return 0;
+        } else if (!rawio_unsupported(rc) && rc != EXDEV) {
+            return rc;
+        }
+
+        /* Not for this pair of files; chunks copied so far stay valid. */
+        *flags &= ~RAWIO_COPY_RANGE;
+    }
+
+    got = rawio_pread(job->src_fd, buf, size, job->src_offset + offset);
+    if (got == -1) {
+        return errno;
+    } else if ((size_t) got < size) {
+        return EIO;
+    }
+
+    if ((*flags & RAWIO_COPY_SPARSE) && rawio_is_zero(buf, size)) {
+        if (fallocate(job->dst_fd, FALLOC_FL_KEEP_SIZE | FALLOC_FL_PUNCH_HOLE,
+                      dst, size) == 0) {
+            return 0;
+        } else if (!rawio_unsupported(errno)) {
+            return errno;
+        }
+
+        *flags &= ~RAWIO_COPY_SPARSE;
+    }
+
+    return rawio_pwrite(job->dst_fd, buf, size, dst) == -1 ? errno : 0;
+}
+
+/* Copy up to max_chunks chunks (all that are left if max_chunks is -1)
+ * through buf, which must hold job->chunk bytes.  Returns 1 if there may be
+ * more work, 0 once the job is finished, failed or cancelled. */
+int rawio_copy_work(rawio_copy_job *job, unsigned char *buf, int max_chunks) {
+    long long offset, chunk = job->chunk;
+    size_t size;
+    int flags, rc;
+
+    while (max_chunks != 0) {
+        pthread_mutex_lock(&job->lock);
+        if (job->error || job->cancel || job->next >= job->size) {
+            pthread_mutex_unlock(&job->lock);
+            return 0;
+        }
+
+        offset = job->next;
+        size = job->size - offset < chunk ? job->size - offset : chunk;
+        job->next += size;
+        flags = job->flags;
+        pthread_mutex_unlock(&job->lock);
+
+        rc = rawio_copy_chunk(job, buf, offset, size, &flags);
+
+        pthread_mutex_lock(&job->lock);
+        if (rc && !job->error) {
+            job->error = rc;
+        }
+
+        job->flags &= flags;
+
+        job->done += size;
+        pthread_mutex_unlock(&job->lock);
+
+        if (max_chunks > 0) {
+            max_chunks--;
+        }
+    }
+
+    return 1;
+}
+
+static void *rawio_copy_thread(void *arg) {
+    rawio_copy_job *job = arg;
+    void *buf = NULL;
+
+    if (posix_memalign(&buf, RAWIO_ALIGN, job->chunk)) {
+        /* The other workers carry on without this one. */
+        return NULL;
+    }
+
+    rawio_copy_work(job, buf, -1);
+    free(buf);
+    return NULL;
+}
+
+/* Start up to n - 1 extra workers for job, the caller being the n-th.
+ * Returns how many were started; pass that to rawio_copy_join(). */
+int rawio_copy_start(rawio_copy_job *job, pthread_t *threads, int n) {
+    int started = 0;
+
+    while (started < n - 1) {
+        if (pthread_create(&threads[started], NULL, rawio_copy_thread, job)) {
+            break;
+        }
+
+        started++;
+    }
+
+    return started;
+}
+
+void rawio_copy_join(pthread_t *threads, int started) {
+    int i;
+
+    for (i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+/* Set up a comparison of size bytes at a_offset on a_fd with the same
+ * number at b_offset on b_fd, chunk bytes at a time.  differs must have
+ * room for one flag per chunk. */
+void rawio_diff_init(rawio_diff_job *job, int a_fd, long long a_offset,
+                     int b_fd, long long b_offset, long long size,
+                     size_t chunk, unsigned char *differs) {
+    memset(job, 0, sizeof(*job));
+    job->a_fd = a_fd;
+    job->a_offset = a_offset;
+    job->b_fd = b_fd;
+    job->b_offset = b_offset;
+    job->size = size;
+    job->chunk = chunk;
+    job->differs = differs;
+    pthread_mutex_init(&job->lock, NULL);
+}
+
+void rawio_diff_destroy(rawio_diff_job *job) {
+    pthread_mutex_destroy(&job->lock);
+}
+
+static int rawio_diff_chunk(rawio_diff_job *job, unsigned char *buf,
+                            long long offset, size_t size) {
+    unsigned char *other = buf + job->chunk;
+    ssize_t got;
+
+    got = rawio_pread(job->a_fd, buf, size, job->a_offset + offset);
+    if (got == -1) {
+        return errno;
+    } else if ((size_t) got < size) {
+        return EIO;
+    }
+
+    got = rawio_pread(job->b_fd, other, size, job->b_offset + offset);
+    if (got == -1) {
+        return errno;
+    } else if ((size_t) got < size) {
+        return EIO;
+    }
+
+    /* Each chunk has its own flag, so no lock is needed to set it. */
+    job->differs[offset / job->chunk] = memcmp(buf, other, size) != 0;
+    return 0;
+}
+
+/* Compare up to max_chunks chunks (all that are left if max_chunks is -1)
+ * using buf, which must hold 2 * job->chunk bytes.  Returns 1 if there may
+ * be more work, 0 once the job is finished, failed or cancelled. */
+int rawio_diff_work(rawio_diff_job *job, unsigned char *buf, int max_chunks) {
+    long long offset, chunk = job->chunk;
+    size_t size;
+    int rc;
+
+    while (max_chunks != 0) {
+        pthread_mutex_lock(&job->lock);
+        if (job->error || job->cancel || job->next >= job->size) {
+            pthread_mutex_unlock(&job->lock);
+            return 0;
+        }
+
+        offset = job->next;
+        size = job->size - offset < chunk ? job->size - offset : chunk;
+        job->next += size;
+        pthread_mutex_unlock(&job->lock);
+
+        rc = rawio_diff_chunk(job, buf, offset, size);
+
+        pthread_mutex_lock(&job->lock);
+        if (rc && !job->error) {
+            job->error = rc;
+        }
+
+        job->done += size;
+        pthread_mutex_unlock(&job->lock);
+
+        if (max_chunks > 0) {
+            max_chunks--;
+        }
+    }
+
+    return 1;
+}
+
+static void *rawio_diff_thread(void *arg) {
+    rawio_diff_job *job = arg;
+    void *buf = NULL;
+
+    if (posix_memalign(&buf, RAWIO_ALIGN, 2 * job->chunk)) {
+        return NULL;
+    }
+
+    rawio_diff_work(job, buf, -1);
+    free(buf);
+    return NULL;
+}
+
+/* Start up to n - 1 extra workers for job, like rawio_copy_start().  Wait
+ * for them with rawio_copy_join(). */
+int rawio_diff_start(rawio_diff_job *job, pthread_t *threads, int n) {
+    int started = 0;
+
+    while (started < n - 1) {
+        if (pthread_create(&threads[started], NULL, rawio_diff_thread, job)) {
+            break;
+        }
+
+        started++;
+    }
+
+    return started;
+}
+
+/* vim:tw=78:ts=4:et:sw=4
+ */
@@ -20,6 +20,7 @@
 
 import _ped
 import parted
+import gc
 import os
 import tempfile
 import unittest
@@ -183,6 +184,26 @@ class RequiresDiskTypes(unittest.TestCase):
             except (IndexError, TypeError, _ped.UnknownTypeException):
                 break
 
+# Mixin for test cases that check a workload does not leave _ped objects or
+# native memory behind.  The workload is run a few times first, so that
+# whatever libparted caches on first use is not counted as a leak.
+class LeakCheck(object):
+    def assertNoLeaks(self, workload, runs=20, slack=256 * 1024):
+        for _ in range(3):
+            workload()
+
+        gc.collect()
+        objects = _ped.live_objects()
+        memory = _ped.native_memory()
+
+        for _ in range(runs):
+            workload()
+
+        gc.collect()
+        self.assertEqual(_ped.live_objects(), objects)
+        self.assertLess(_ped.native_memory() - memory, slack,
+                        "%d runs leaked native memory" % runs)
+
 # Base class for any test case that requires a list being built via successive
 # calls of some function.  The function must raise IndexError when there's no
 # more output to add to the return list.  This class is most useful for all
@@ -20,6 +20,8 @@
 #
 
 import _ped
+import array
+import gc
 import unittest
 from tests.baseclass import RequiresDevice, RequiresDeviceAlignment
 
@@ -65,6 +67,18 @@ class AlignmentGetSetTestCase(unittest.TestCase):
         # Check that looking for invalid attributes fails properly.
         self.assertRaises(AttributeError, getattr, self.a, "blah")
 
+class AlignmentRecycleTestCase(unittest.TestCase):
+    def runTest(self):
+        # Alignments hold no references, so the collector never sees them.
+        self.assertFalse(gc.is_tracked(_ped.Alignment(27, 49)))
+
+        # Freed alignments are reused, and must come back as new.
+        for i in range(3):
+            aligns = [_ped.Alignment(n, n + i) for n in range(1000)]
+            self.assertEqual([(a.offset, a.grain_size) for a in aligns],
+                             [(n, n + i) for n in range(1000)])
+            del aligns
+
 class AlignmentDuplicateTestCase(unittest.TestCase):
     def setUp(self):
         self.a = _ped.Alignment(27, 49)
@@ -220,6 +234,40 @@ class AlignmentIsAlignedTestCase(RequiresDevice):
         self.assertTrue(self.a.is_aligned(self.g, 20))
         self.assertFalse(self.a.is_aligned(self.g, 23))
 
+class AlignmentManyTestCase(RequiresDevice):
+    def setUp(self):
+        RequiresDevice.setUp(self)
+        self.alignments = [_ped.Alignment(10, 0), _ped.Alignment(512, 34),
+                           _ped.Alignment(0, 8)]
+        self.geometry = _ped.Geometry(self._device, start=10, length=100)
+        self.sectors = array.array('q', range(-20, 150))
+
+    def scalar(self, fn, sector):
+        try:
+            return fn(self.geometry, sector)
+        except ArithmeticError:
+            return -1
+
+    def runTest(self):
+        for a in self.alignments:
+            self.assertEqual(list(a.align_up_many(self.geometry, self.sectors)),
+                             [self.scalar(a.align_up, s) for s in self.sectors])
+            self.assertEqual(list(a.align_down_many(self.geometry, self.sectors)),
+                             [self.scalar(a.align_down, s) for s in self.sectors])
+            self.assertEqual(list(a.align_nearest_many(self.geometry, self.sectors)),
+                             [self.scalar(a.align_nearest, s) for s in self.sectors])
+            self.assertEqual(list(a.is_aligned_many(self.geometry, self.sectors)),
+                             [int(a.is_aligned(self.geometry, s)) for s in self.sectors])
+
+        # memoryviews work too, other item types do not
+        a = self.alignments[1]
+        self.assertEqual(list(a.align_up_many(self.geometry, memoryview(self.sectors))),
+                         list(a.align_up_many(self.geometry, self.sectors)))
+        self.assertEqual(len(a.align_up_many(self.geometry, array.array('q'))), 0)
+        self.assertRaises(TypeError, a.align_up_many, self.geometry,
+                          array.array('i', [1, 2, 3]))
+        self.assertRaises(TypeError, a.align_up_many, self.geometry, [1, 2, 3])
+
 class AlignmentStrTestCase(unittest.TestCase):
     def setUp(self):
         self.alignment = _ped.Alignment(10, 0)
@@ -20,6 +20,7 @@
 #
 
 import _ped
+import gc
 import unittest
 
 from tests.baseclass import RequiresDevice
@@ -48,6 +49,21 @@ class CHSGeometryGetSetTestCase(RequiresDevice):
         self.assertIsInstance(chs.heads, int)
         self.assertIsInstance(chs.sectors, int)
 
+class CHSGeometryRecycleTestCase(RequiresDevice):
+    def runTest(self):
+        # CHSGeometries hold no references, so the collector never sees them.
+        self.assertFalse(gc.is_tracked(self._device.hw_geom))
+
+        expected = (self._device.hw_geom.cylinders, self._device.hw_geom.heads,
+                    self._device.hw_geom.sectors)
+
+        # Freed ones are reused, and must come back as new.
+        for _ in range(3):
+            geoms = [_ped.device_get(self.path).hw_geom for _ in range(500)]
+            self.assertEqual(set((g.cylinders, g.heads, g.sectors)
+                                 for g in geoms), set([expected]))
+            del geoms
+
 class CHSGeometryStrTestCase(RequiresDevice):
     def runTest(self):
         expected = "_ped.CHSGeometry instance --\n  cylinders: %d  heads: %d  sectors: %d" % (self._device.hw_geom.cylinders, self._device.hw_geom.heads, self._device.hw_geom.sectors,)
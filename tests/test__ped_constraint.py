@@ -20,6 +20,8 @@
 #
 
 import _ped
+import os
+import tempfile
 
 from tests.baseclass import RequiresDevice
 
@@ -190,6 +192,89 @@ class ConstraintSolveNearestTestCase(RequiresDevice):
         result = self.c1.solve_nearest(self.g1)
         self.assertEqual(result, self.g1)
 
+class ConstraintSolverCacheTestCase(RequiresDevice):
+    def setUp(self):
+        RequiresDevice.setUp(self)
+        self.addCleanup(_ped.constraint_solver_cache, False)
+        self.c1 = self._device.get_constraint()
+        self.g1 = _ped.Geometry(self._device, 1, 8)
+
+    def runTest(self):
+        self.assertFalse(_ped.constraint_solver_cache(True))
+        self.assertTrue(_ped.constraint_solver_cache())
+        _ped.constraint_solver_cache_clear()
+
+        # The first solve misses, later ones come out of the cache but
+        # still return new, equal objects.
+        first = self.c1.solve_max()
+        second = self.c1.solve_max()
+        self.assertEqual(first, second)
+        self.assertIsNot(first, second)
+        self.assertEqual(self.c1.solve_nearest(self.g1), self.g1)
+        self.assertEqual(self.c1.solve_nearest(self.g1), self.g1)
+
+        info = _ped.constraint_solver_cache_info()
+        self.assertTrue(info["enabled"])
+        self.assertEqual(info["misses"], 2)
+        self.assertEqual(info["hits"], 2)
+        self.assertEqual(info["size"], 2)
+
+        # Changing the constraint changes the key.
+        self.c1.max_size = 10
+        self.assertLessEqual(self.c1.solve_max().length, 10)
+
+        # Turning the cache off empties it.
+        self.assertTrue(_ped.constraint_solver_cache(False))
+        self.assertEqual(_ped.constraint_solver_cache_info()["size"], 0)
+
+class ConstraintSolverCacheSharedTestCase(RequiresDevice):
+    def setUp(self):
+        RequiresDevice.setUp(self)
+        self.addCleanup(_ped.constraint_solver_cache, False)
+
+        # A second device of the same size at another path.
+        (fd, self.path2) = tempfile.mkstemp(prefix="temp-device-")
+        self.addCleanup(os.unlink, self.path2)
+        os.ftruncate(fd, os.path.getsize(self.path))
+        os.close(fd)
+        self._device2 = _ped.device_get(self.path2)
+
+    def runTest(self):
+        _ped.constraint_solver_cache(True)
+        _ped.constraint_solver_cache_clear()
+
+        first = self._device.get_constraint().solve_max()
+        second = self._device2.get_constraint().solve_max()
+
+        # The second disk is answered from the first one's entry, but the
+        # result is on its own device.
+        info = _ped.constraint_solver_cache_info()
+        self.assertEqual(info["misses"], 1)
+        self.assertEqual(info["hits"], 1)
+        self.assertEqual(second.dev.path, self.path2)
+        self.assertEqual((second.start, second.end), (first.start, first.end))
+
+class ConstraintCachedTestCase(RequiresDevice):
+    def setUp(self):
+        RequiresDevice.setUp(self)
+        self.c = self._device.get_constraint()
+
+    def runTest(self):
+        self.assertEqual(self.c.solve_max().end, self._device.length - 1)
+
+        # Replacing a member invalidates the native constraint.
+        self.c.end_range = _ped.Geometry(self._device, 0, 50)
+        self.assertLessEqual(self.c.solve_max().end, 49)
+
+        # So does changing a member object in place.
+        self.c.end_range.set_end(20)
+        self.assertLessEqual(self.c.solve_max().end, 20)
+
+        # Members that are not the right type are caught when used.
+        self.c.start_align = 47
+        self.assertRaises(TypeError, self.c.solve_max)
+        self.assertRaises(AttributeError, delattr, self.c, "start_align")
+
 class ConstraintIsSolutionTestCase(RequiresDevice):
     def setUp(self):
         RequiresDevice.setUp(self)
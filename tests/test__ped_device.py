@@ -20,6 +20,9 @@
 #
 
 import _ped
+import gc
+import os
+import struct
 import unittest
 
 from tests.baseclass import RequiresDevice
@@ -41,6 +44,27 @@ class DeviceGetSetTestCase(RequiresDevice):
             self.assertNotEqual(getattr(self._device, attr), None)
             self.assertRaises(AttributeError, setattr, self._device, attr, 47)
 
+class DeviceCHSGeometryTestCase(RequiresDevice):
+    def runTest(self):
+        # A Device holds its CHS geometries as plain values, so getting one
+        # allocates a single object and the collector never sees it.
+        before = _ped.live_objects()
+        device = _ped.device_get(self.path)
+        after = _ped.live_objects()
+        self.assertEqual(after["Device"], before["Device"] + 1)
+        self.assertEqual(after["CHSGeometry"], before["CHSGeometry"])
+        self.assertFalse(gc.is_tracked(device))
+
+        # The CHSGeometry objects are made on access.
+        self.assertIsInstance(device.hw_geom, _ped.CHSGeometry)
+        self.assertIsInstance(device.bios_geom, _ped.CHSGeometry)
+        self.assertEqual(device.hw_geom, self._device.hw_geom)
+        self.assertEqual(device.bios_geom, self._device.bios_geom)
+        self.assertRaises(AttributeError, setattr, device, "hw_geom", None)
+
+        self.assertIn("hw_geom: %s" % device.hw_geom, str(device))
+        self.assertEqual(device, self._device)
+
 class DeviceIsBusyTestCase(RequiresDevice):
     def runTest(self):
         # Devices aren't busy until they're mounted.
@@ -160,6 +184,86 @@ class DeviceWriteTestCase(unittest.TestCase):
         # TODO
         self.fail("Unimplemented test case.")
 
+class DeviceDirectIOTestCase(RequiresDevice):
+    def openFds(self):
+        return len(os.listdir("/proc/self/fd"))
+
+    def runTest(self):
+        fds = self.openFds()
+        self.assertFalse(self._device.direct_io)
+        self._device.direct_io = True
+        self.assertTrue(self._device.direct_io)
+
+        # The O_DIRECT descriptor is opened once, when direct_io is set.
+        self.assertEqual(self.openFds(), fds + 1)
+        self._device.direct_io = True
+        self.assertEqual(self.openFds(), fds + 1)
+
+        # Direct I/O still honours the open and external access state.
+        self.assertRaises(_ped.IOException, self._device.read, 0, 1)
+
+        self._device.open()
+        data = bytes(bytearray(range(256))) * 8
+        self.assertEqual(self._device.write(data, 4, 4), 1)
+        self.assertEqual(self._device.read(4, 4), data)
+
+        with open(self.path, "rb") as f:
+            f.seek(4 * 512)
+            self.assertEqual(f.read(2048), data)
+
+        # Repeated reads of the same size reuse pooled buffers.
+        for _ in range(4):
+            self.assertEqual(self._device.read(0, 8)[2048:], data)
+
+        self.assertRaises(ValueError, self._device.read,
+                          self._device.length - 1, 2)
+        self.assertRaises(ValueError, self._device.write, data, 0, 8)
+        self.assertRaises(TypeError, self._device.write, 47, 0, 1)
+
+        self._device.begin_external_access()
+        self.assertRaises(_ped.IOException, self._device.read, 0, 1)
+        self._device.end_external_access()
+        self._device.close()
+
+        # Clearing direct_io closes it again.
+        self._device.direct_io = False
+        self.assertEqual(self.openFds(), fds)
+
+class DeviceMmapViewTestCase(RequiresDevice):
+    def runTest(self):
+        # The device has to be open and not in external access mode.
+        self.assertRaises(_ped.IOException, self._device.mmap_view, 0, 1)
+
+        with open(self.path, "r+b") as f:
+            f.seek(3 * 512)
+            f.write(b"\xaa" * 512)
+
+        self._device.open()
+        view = self._device.mmap_view(3, 2)
+        self.assertTrue(view.readonly)
+        self.assertEqual(len(view), 1024)
+        self.assertEqual(view[:512].tobytes(), b"\xaa" * 512)
+        self.assertEqual(view[512:].tobytes(), b"\0" * 512)
+        view.release()
+
+        view = self._device.mmap_view(4, 1, True)
+        self.assertFalse(view.readonly)
+        view[:4] = b"pyp\xff"
+        view.release()
+
+        with open(self.path, "rb") as f:
+            f.seek(4 * 512)
+            self.assertEqual(f.read(4), b"pyp\xff")
+
+        self.assertRaises(ValueError, self._device.mmap_view,
+                          self._device.length - 1, 2)
+        self.assertRaises(ValueError, self._device.mmap_view, 0, 0)
+
+        self._device.begin_external_access()
+        self.assertRaises(_ped.IOException, self._device.mmap_view, 0, 1)
+        self._device.end_external_access()
+        self._device.close()
+
 class DeviceSyncTestCase(RequiresDevice):
     def runTest(self):
         # Can't sync a device that's not open or is in external mode.
@@ -240,6 +344,90 @@ class DeviceGetOptimumAlignmentTestCase(RequiresDevice):
         self.assertEqual(alignment.grain_size, 2048)
         self.assertEqual(alignment.offset, 0)
 
+class DeviceFindSignaturesTestCase(RequiresDevice):
+    def runTest(self):
+        with open(self.path, "r+b") as f:
+            f.seek(510)
+            f.write(b"\x55\xaaEFI PART")
+            f.seek(8192 + 4086)
+            f.write(b"SWAPSPACE2")
+
+        self.assertEqual(self._device.find_signatures(),
+                         [(510, "dos"), (512, "gpt"),
+                          (8192 + 4086, "linux-swap(v1)")])
+        self.assertEqual(self._device.find_signatures(16, 100),
+                         [(8192 + 4086, "linux-swap(v1)")])
+        self.assertEqual(self._device.find_signatures(100, 10), [])
+        self.assertRaises(ValueError, self._device.find_signatures,
+                          self._device.length, 1)
+
+class DeviceFindSignaturesDosTestCase(RequiresDevice):
+    def runTest(self):
+        # A used entry: type 0x83, starting at sector 2048, 100 sectors.
+        entry = b"\0" * 4 + b"\x83" + b"\0" * 3 + struct.pack("<II", 2048, 100)
+
+        with open(self.path, "r+b") as f:
+            # A stray 0x55AA in the data area, with nothing in front of it.
+            f.seek(8192 + 510)
+            f.write(b"\x55\xaa")
+            # The same behind a bogus boot indicator, as in boot code.
+            f.seek(16384 + 446)
+            f.write(b"\x42" + entry[1:])
+            f.seek(16384 + 510)
+            f.write(b"\x55\xaa")
+            # An EBR with one logical partition in it.
+            f.seek(24576 + 446)
+            f.write(entry)
+            f.seek(24576 + 510)
+            f.write(b"\x55\xaa")
+
+        self.assertEqual(self._device.find_signatures(),
+                         [(24576 + 510, "dos")])
+
+class DeviceZeroRangeTestCase(RequiresDevice):
+    def runTest(self):
+        with open(self.path, "r+b") as f:
+            f.write(b"\xff" * 4096)
+
+        reports = []
+        self.assertTrue(self._device.zero_range(2, 4, reports.append))
+
+        with open(self.path, "rb") as f:
+            data = f.read(4096)
+
+        self.assertEqual(data[:1024], b"\xff" * 1024)
+        self.assertEqual(data[1024:3072], b"\0" * 2048)
+        self.assertEqual(data[3072:], b"\xff" * 1024)
+
+        self.assertTrue(all(isinstance(t, _ped.Timer) for t in reports))
+        self.assertEqual(reports[0].frac, 0)
+        self.assertEqual(reports[-1].frac, 1)
+        self.assertEqual(reports[-1].state_name, "zeroing")
+
+        self.assertRaises(ValueError, self._device.zero_range,
+                          self._device.length - 1, 2)
+        self.assertRaises(TypeError, self._device.zero_range, 0, 1, 47)
+
+        def cancel(timer):
+            raise RuntimeError("cancelled")
+
+        self.assertRaises(RuntimeError, self._device.zero_range, 0, 1, cancel)
+
+class DeviceDiscardRangeTestCase(RequiresDevice):
+    def runTest(self):
+        with open(self.path, "r+b") as f:
+            f.write(b"\xff" * 8192)
+
+        # Punching holes depends on the filesystem holding the image.
+        if self._device.discard_range(8, 8):
+            with open(self.path, "rb") as f:
+                data = f.read(8192)
+
+            self.assertEqual(data[:4096], b"\xff" * 4096)
+            self.assertEqual(data[4096:], b"\0" * 4096)
+
+        self.assertRaises(ValueError, self._device.discard_range, -1, 2)
+
 class UnitFormatCustomByteTestCase(RequiresDevice):
     def setUp(self):
         RequiresDevice.setUp(self)
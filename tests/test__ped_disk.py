@@ -20,6 +20,7 @@
 #
 
 import _ped
+import struct
 import unittest
 
 from tests.baseclass import RequiresDevice, RequiresLabeledDevice, RequiresDisk
@@ -138,6 +139,20 @@ class DiskGetFlagTestCase(RequiresDisk):
         flag = self._disk.get_flag(_ped.DISK_CYLINDER_ALIGNMENT)
         self.assertIsInstance(flag, bool)
 
+class DiskGetSetFlagsTestCase(RequiresDisk):
+    def runTest(self):
+        # These tests assume an MSDOS label as given by RequiresDisk
+        mask = 1 << _ped.DISK_CYLINDER_ALIGNMENT
+        self.assertTrue(self._disk.set_flags(mask))
+        self.assertEqual(self._disk.get_flags(), mask)
+        self.assertTrue(self._disk.set_flags(0))
+        self.assertEqual(self._disk.get_flags(), 0)
+
+        # GPT_PMBR_BOOT is not available on MSDOS, so nothing is changed.
+        with self.assertRaises(_ped.DiskException):
+            self._disk.set_flags(mask | (1 << _ped.DISK_GPT_PMBR_BOOT))
+        self.assertEqual(self._disk.get_flags(), 0)
+
 class DiskIsFlagAvailableTestCase(RequiresDisk):
     def runTest(self):
         # We don't know which flags should be available and which shouldn't,
@@ -220,6 +235,135 @@ class DiskExtendedPartitionTestCase(RequiresDisk):
         self.assertRaises(_ped.PartitionException,
                           self._disk.extended_partition)
 
+class DiskAuditAlignmentTestCase(RequiresDisk):
+    def runTest(self):
+        for (start, end) in [(64, 127), (130, 197)]:
+            part = _ped.Partition(self._disk, _ped.PARTITION_NORMAL, start, end)
+            self._disk.add_partition(part, _ped.constraint_exact(part.geom))
+
+        # Only the second partition is off the 8 sector grain.
+        self.assertEqual(self._disk.audit_alignment(_ped.Alignment(0, 8)),
+                         [(2, 130, 197, 128, 199)])
+        self.assertEqual(self._disk.audit_alignment(_ped.Alignment(0, 1)), [])
+        self.assertIsInstance(self._disk.audit_alignment(), list)
+        self.assertRaises(TypeError, self._disk.audit_alignment, 8)
+
+class DiskProbeFilesystemsTestCase(RequiresDisk):
+    def runTest(self):
+        for (start, end) in [(64, 127), (130, 260)]:
+            part = _ped.Partition(self._disk, _ped.PARTITION_NORMAL, start, end)
+            self._disk.add_partition(part, _ped.constraint_exact(part.geom))
+
+        # A swap v1 header (version 1, last page 7), as mkswap writes it.
+        with open(self.path, "r+b") as f:
+            f.seek(64 * self._device.sector_size + 1024)
+            f.write(struct.pack("<II", 1, 7))
+            f.seek(64 * self._device.sector_size + 4086)
+            f.write(b"SWAPSPACE2")
+
+        # Both with one read per signature block and with one read of the
+        # first 68 KiB of each partition.
+        self.addCleanup(_ped.file_system_probe_coalesce, 0)
+
+        for kib in [0, 68]:
+            _ped.file_system_probe_coalesce(kib)
+
+            for workers in [1, 4]:
+                probed = self._disk.probe_filesystems(workers=workers)
+                self.assertEqual(sorted(probed.keys()), [1, 2])
+                self.assertEqual(probed[1].name, "linux-swap(v1)")
+                self.assertIsNone(probed[2])
+
+        # Swap is recognized natively, so libparted only reads the second,
+        # empty partition.
+        self.addCleanup(_ped.trace_drain)
+        self.addCleanup(_ped.trace_enable, False)
+        _ped.trace_enable(True)
+        self._disk.probe_filesystems()
+        reads = [r for r in _ped.trace_drain() if r[0] == "read"]
+        self.assertNotEqual(reads, [])
+
+        for (op, start, count, seconds, call) in reads:
+            self.assertGreaterEqual(start, 130)
+            self.assertLessEqual(start + count, 261)
+
+        self.assertRaises(ValueError, self._disk.probe_filesystems, workers=0)
+
+class DiskProbeFilesystemsAgreeTestCase(RequiresDisk):
+    """
+        probe_filesystems() must report what libparted's own probe does for
+        a FAT32 volume with a blank label string, and for one with a stale
+        FAT16 label left where a FAT16 boot sector keeps it.
+    """
+    def fat32BootSector(self, length, reserved):
+        bs = struct.pack("<3s8sHBHBHHBHHHIIIHHIHH12sBBBI11s8s",
+                         b"\xeb\x58\x90", b"MSWIN4.1", 512, 1, 32, 2, 0, 0,
+                         0xf8, 0, 32, 2, 0, length, 1, 0, 0, 2, 1, 6,
+                         reserved, 0x80, 0, 0x29, 0x1234abcd,
+                         b"NO NAME    ", b"        ")
+        return bs + b"\0" * (510 - len(bs)) + b"\x55\xaa"
+
+    def runTest(self):
+        part = _ped.Partition(self._disk, _ped.PARTITION_NORMAL, 64, 259)
+        self._disk.add_partition(part, _ped.constraint_exact(part.geom))
+
+        for reserved in [b"\0" * 12, b"\0\0FAT16   \0\0"]:
+            with open(self.path, "r+b") as f:
+                f.seek(64 * self._device.sector_size)
+                f.write(self.fat32BootSector(part.geom.length, reserved))
+
+            try:
+                expected = _ped.file_system_probe(part.geom).name
+            except _ped.FileSystemException:
+                expected = None
+
+            probed = self._disk.probe_filesystems()[part.num]
+            self.assertEqual(probed.name if probed else None, expected)
+
+class DiskProbeFilesystemsReadsTestCase(RequiresDisk):
+    """
+        A partition recognized natively is read once with coalescing on,
+        once per signature block with it off, and never by libparted.
+    """
+    def setUp(self):
+        RequiresDisk.setUp(self)
+        self.addCleanup(_ped.file_system_probe_coalesce, 0)
+        self.addCleanup(_ped.stats_enable, False)
+        self.addCleanup(_ped.stats_reset)
+        self.addCleanup(_ped.trace_drain)
+        self.addCleanup(_ped.trace_enable, False)
+
+    def bytesRead(self):
+        _ped.stats_reset()
+        _ped.trace_drain()
+        self.assertEqual(self._disk.probe_filesystems()[1].name,
+                         "linux-swap(v1)")
+        self.assertEqual([r for r in _ped.trace_drain() if r[0] == "read"], [])
+        return _ped.stats()["Disk.probe_filesystems"]["bytes_read"]
+
+    def runTest(self):
+        # Long enough for every row of the signature table to be checked.
+        part = _ped.Partition(self._disk, _ped.PARTITION_NORMAL, 64, 263)
+        self._disk.add_partition(part, _ped.constraint_exact(part.geom))
+
+        with open(self.path, "r+b") as f:
+            f.seek(64 * self._device.sector_size + 1024)
+            f.write(struct.pack("<II", 1, 7))
+            f.seek(64 * self._device.sector_size + 4086)
+            f.write(b"SWAPSPACE2")
+
+        _ped.stats_enable(True)
+        _ped.trace_enable(True)
+
+        # One read of the first 68 KiB.
+        _ped.file_system_probe_coalesce(68)
+        self.assertEqual(self.bytesRead(), 68 * 1024)
+
+        # One read per distinct block: 1 KiB for ext, 4 KiB for swap, and a
+        # sector each for xfs, btrfs, ntfs and FAT, HFS+, jfs and reiserfs.
+        _ped.file_system_probe_coalesce(0)
+        self.assertEqual(self.bytesRead(), 1024 + 4096 + 6 * 512)
+
 class DiskStrTestCase(RequiresDisk):
     def runTest(self):
         expected = "_ped.Disk instance --\n  dev: %s  type: %s" % \
@@ -19,7 +19,11 @@
 #
 
 import _ped
+import gc
+import hashlib
+import os
 import six
+import struct
 from tests.baseclass import RequiresDevice
 
 # One class per method, multiple tests per class.  For these simple methods,
@@ -84,6 +88,18 @@ class GeometryDuplicateTestCase(RequiresDevice):
         self.assertEqual(self.g.length, self.dup.length)
         self.assertEqual(self.g.end, self.dup.end)
 
+class GeometryRecycleTestCase(RequiresDevice):
+    def runTest(self):
+        # Freed geometries are reused, and must come back as new.
+        for i in range(3):
+            geoms = [_ped.Geometry(self._device, start=n, length=i + 1)
+                     for n in range(1000)]
+            self.assertEqual([(g.start, g.length) for g in geoms],
+                             [(n, i + 1) for n in range(1000)])
+            self.assertTrue(all(g.dev is geoms[0].dev for g in geoms))
+            self.assertTrue(gc.is_tracked(geoms[0]))
+            del geoms
+
 class GeometryIntersectTestCase(RequiresDevice):
     def setUp(self):
         RequiresDevice.setUp(self)
@@ -225,6 +241,19 @@ class GeometryTestEqualTestCase(RequiresDevice):
         self.g2.set_end(50)
         self.assertFalse(self.g1.test_equal(self.g2))
 
+class GeometryCompareHashTestCase(RequiresDevice):
+    def runTest(self):
+        g1 = _ped.Geometry(self._device, start=0, length=100)
+        g2 = _ped.Geometry(_ped.device_get(self.path), start=0, length=100)
+
+        # Separate _ped.Device objects for the same path are the same device.
+        self.assertEqual(g1, g2)
+        self.assertEqual(hash(g1), hash(g2))
+        self.assertEqual(len(set([g1, g2])), 1)
+
+        g2.set_start(5)
+        self.assertNotEqual(g1, g2)
+
 class GeometryTestSectorInsideTestCase(RequiresDevice):
     def setUp(self):
         RequiresDevice.setUp(self)
@@ -366,6 +395,159 @@ class GeometryMapTestCase(RequiresDevice):
 
         self._device.close()
 
+class GeometryCopyToTestCase(RequiresDevice):
+    def setUp(self):
+        RequiresDevice.setUp(self)
+        self.src = _ped.Geometry(self._device, start=0, length=64)
+        self.dst = _ped.Geometry(self._device, start=128, length=64)
+
+        # Random data with a run of zeros in the middle.
+        self.data = os.urandom(16 * 512) + b"\0" * (32 * 512) + os.urandom(16 * 512)
+        with open(self.path, "r+b") as f:
+            f.write(self.data)
+
+    def runTest(self):
+        for threads in [1, 2, 4]:
+            reports = []
+            self.assertTrue(self.src.copy_to(self.dst, 8, threads,
+                                             reports.append))
+            self.assertEqual(reports[-1].frac, 1)
+
+            with open(self.path, "rb") as f:
+                f.seek(128 * 512)
+                self.assertEqual(f.read(64 * 512), self.data)
+
+        small = _ped.Geometry(self._device, start=128, length=63)
+        overlap = _ped.Geometry(self._device, start=32, length=64)
+        self.assertRaises(ValueError, self.src.copy_to, small)
+        self.assertRaises(ValueError, self.src.copy_to, overlap)
+        self.assertRaises(ValueError, self.src.copy_to, self.dst, 0)
+        self.assertRaises(ValueError, self.src.copy_to, self.dst, 8, 0)
+
+class GeometryDiffTestCase(RequiresDevice):
+    def setUp(self):
+        RequiresDevice.setUp(self)
+        self.old = _ped.Geometry(self._device, start=0, length=60)
+        self.new = _ped.Geometry(self._device, start=64, length=60)
+
+        data = bytearray(os.urandom(60 * 512))
+        with open(self.path, "r+b") as f:
+            f.write(data)
+
+            # Change sectors 9, 17 and 58 in the copy.
+            for sector in [9, 17, 58]:
+                data[sector * 512] ^= 0xff
+
+            f.seek(64 * 512)
+            f.write(data)
+
+    def runTest(self):
+        for threads in [1, 2, 4]:
+            reports = []
+            self.assertEqual(self.old.diff(self.new, 8, threads,
+                                           reports.append),
+                             [(8, 16), (56, 4)])
+            self.assertEqual(reports[-1].frac, 1)
+
+        self.assertEqual(self.old.diff(self.new, 1), [(9, 1), (17, 1), (58, 1)])
+        self.assertEqual(self.old.diff(self.old), [])
+
+        short = _ped.Geometry(self._device, start=64, length=59)
+        self.assertRaises(ValueError, self.old.diff, short)
+        self.assertRaises(ValueError, self.old.diff, self.new, 0)
+        self.assertRaises(ValueError, self.old.diff, self.new, 8, 0)
+
+class GeometryDigestTestCase(RequiresDevice):
+    def setUp(self):
+        RequiresDevice.setUp(self)
+        self.geom = _ped.Geometry(self._device, start=4, length=24)
+
+        # Three 8 sector chunks, the first and last identical.
+        block = os.urandom(8 * 512)
+        self.data = block + os.urandom(8 * 512) + block
+        with open(self.path, "r+b") as f:
+            f.seek(4 * 512)
+            f.write(self.data)
+
+    def crc32c(self, data):
+        crc = 0xffffffff
+        for byte in bytearray(data):
+            crc ^= byte
+            for _ in range(8):
+                crc = (crc >> 1) ^ (0x82f63b78 & -(crc & 1))
+        return "%08x" % (crc ^ 0xffffffff)
+
+    def xxh64(self, data, seed=0):
+        p1, p2, p3 = 0x9e3779b185ebca87, 0xc2b2ae3d27d4eb4f, 0x165667b19e3779f9
+        p4, p5 = 0x85ebca77c2b2ae63, 0x27d4eb2f165667c5
+        m = 0xffffffffffffffff
+        rotl = lambda x, r: ((x << r) | (x >> (64 - r))) & m
+        rnd = lambda acc, lane: rotl((acc + lane * p2) & m, 31) * p1 & m
+        data = bytes(data)
+        n, i = len(data), 0
+
+        if n >= 32:
+            v = [(seed + p1 + p2) & m, (seed + p2) & m, seed, (seed - p1) & m]
+            while i + 32 <= n:
+                for j in range(4):
+                    v[j] = rnd(v[j], struct.unpack_from("<Q", data, i)[0])
+                    i += 8
+            h = (rotl(v[0], 1) + rotl(v[1], 7) + rotl(v[2], 12) +
+                 rotl(v[3], 18)) & m
+            for lane in v:
+                h = ((h ^ rnd(0, lane)) * p1 + p4) & m
+        else:
+            h = (seed + p5) & m
+
+        h = (h + n) & m
+        while i + 8 <= n:
+            h ^= rnd(0, struct.unpack_from("<Q", data, i)[0])
+            h = (rotl(h, 27) * p1 + p4) & m
+            i += 8
+        if i + 4 <= n:
+            h ^= struct.unpack_from("<I", data, i)[0] * p1 & m
+            h = (rotl(h, 23) * p2 + p3) & m
+            i += 4
+        for byte in bytearray(data[i:]):
+            h ^= byte * p5 & m
+            h = rotl(h, 11) * p1 & m
+
+        h = (h ^ (h >> 33)) * p2 & m
+        h = (h ^ (h >> 29)) * p3 & m
+        return "%016x" % (h ^ (h >> 32))
+
+    def runTest(self):
+        self.assertEqual(self.geom.digest(),
+                         hashlib.sha256(self.data).hexdigest())
+        self.assertEqual(self.geom.digest("sha256", 8, True),
+                         [hashlib.sha256(self.data[i:i + 4096]).hexdigest()
+                          for i in range(0, len(self.data), 4096)])
+        self.assertEqual(self.geom.digest("crc32c", 5),
+                         self.crc32c(self.data))
+        self.assertEqual(self.geom.digest("crc32c", 8, True)[1],
+                         self.crc32c(self.data[4096:8192]))
+
+        # Check the reference against the published XXH64 test vectors
+        # before trusting it with the geometry's contents.
+        self.assertEqual(self.xxh64(b""), "ef46db3751d8e999")
+        self.assertEqual(self.xxh64(b"abc"), "44bc2cf5ad770999")
+        self.assertEqual(self.geom.digest("xxh64"), self.xxh64(self.data))
+        self.assertEqual(self.geom.digest("xxh64", 8, True)[1],
+                         self.xxh64(self.data[4096:8192]))
+
+        # The whole digest does not depend on the chunk size.
+        self.assertEqual(self.geom.digest("xxh64", 3),
+                         self.geom.digest("xxh64", 24))
+
+        for algorithm in ["crc32c", "xxh64", "sha256"]:
+            chunks = self.geom.digest(algorithm, 8, True)
+            self.assertEqual(len(chunks), 3)
+            self.assertEqual(chunks[0], chunks[2])
+            self.assertNotEqual(chunks[0], chunks[1])
+
+        self.assertRaises(ValueError, self.geom.digest, "md4")
+        self.assertRaises(ValueError, self.geom.digest, "sha256", 0)
+
 class GeometryStrTestCase(RequiresDevice):
     def setUp(self):
         RequiresDevice.setUp(self)
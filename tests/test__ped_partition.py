@@ -72,6 +72,27 @@ class PartitionGetSetTestCase(RequiresPartition):
         # Check that looking for invalid attributes fails properly.
         self.assertRaises(AttributeError, getattr, self._part, "blah")
 
+class PartitionCompareHashTestCase(RequiresPartition):
+    def runTest(self):
+        same = _ped.Partition(disk=self._disk, type=_ped.PARTITION_NORMAL,
+                              start=0, end=100, fs_type=_ped.file_system_type_get("ext2"))
+        other = _ped.Partition(disk=self._disk, type=_ped.PARTITION_NORMAL,
+                               start=0, end=200, fs_type=_ped.file_system_type_get("ext2"))
+
+        self.assertEqual(self._part, self._part)
+        self.assertEqual(self._part, same)
+        self.assertEqual(hash(self._part), hash(same))
+        self.assertNotEqual(self._part, other)
+        self.assertIn(same, set([self._part, other]))
+
+        # Being numbered when added to the disk does not move it in a set.
+        part = _ped.Partition(disk=self._disk, type=_ped.PARTITION_NORMAL,
+                              start=100, end=199)
+        parts = set([part])
+        self._disk.add_partition(part, _ped.constraint_exact(part.geom))
+        self.assertNotEqual(part.num, -1)
+        self.assertIn(part, parts)
+
 class PartitionDestroyTestCase(RequiresPartition):
     def runTest(self):
         self.assertEqual(self._part.destroy(), None)
@@ -109,6 +130,28 @@ class PartitionGetFlagTestCase(RequiresPartition):
 
 
 
+class PartitionGetSetFlagsTestCase(RequiresPartition):
+    def runTest(self):
+        mask = (1 << _ped.PARTITION_BOOT) | (1 << _ped.PARTITION_RAID)
+        self.assertTrue(self._part.set_flags(mask))
+        self.assertEqual(self._part.get_flags(), mask)
+        self.assertTrue(self._part.get_flag(_ped.PARTITION_RAID))
+
+        self.assertTrue(self._part.set_flags(1 << _ped.PARTITION_LVM))
+        self.assertFalse(self._part.get_flag(_ped.PARTITION_BOOT))
+        self.assertEqual(self._part.get_flags(), 1 << _ped.PARTITION_LVM)
+
+        # An unknown flag is never available, so nothing is changed.
+        with self.assertRaises(_ped.PartitionException):
+            self._part.set_flags(1 << 60)
+        self.assertEqual(self._part.get_flags(), 1 << _ped.PARTITION_LVM)
+
+        # msdos turns RAID off when LVM is turned on, so both cannot be had.
+        both = (1 << _ped.PARTITION_RAID) | (1 << _ped.PARTITION_LVM)
+        with self.assertRaises(_ped.PartitionException):
+            self._part.set_flags(both)
+        self.assertNotEqual(self._part.get_flags(), both)
+
 class PartitionIsFlagAvailableTestCase(RequiresPartition):
     def runTest(self):
         # We don't know which flags should be available and which shouldn't,
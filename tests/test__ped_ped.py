@@ -24,9 +24,10 @@
 
 import os
 import _ped
+import tempfile
 import unittest
 
-from tests.baseclass import BuildList, RequiresDevice, RequiresFileSystem
+from tests.baseclass import BuildList, LeakCheck, RequiresDevice, RequiresDisk, RequiresFileSystem
 
 # One class per method, multiple tests per class.  For these simple methods,
 # that seems like good organization.  More complicated methods may require
@@ -286,6 +287,72 @@ class FileSystemProbeSpecificTestCase(RequiresFileSystem):
                 result = _ped.file_system_probe_specific(ty, self._geometry)
                 self.assertEqual(result, None)
 
+class FileSystemProbeCoalesceTestCase(unittest.TestCase):
+    def runTest(self):
+        self.addCleanup(_ped.file_system_probe_coalesce, 0)
+
+        self.assertEqual(_ped.file_system_probe_coalesce(68), 0)
+        self.assertEqual(_ped.file_system_probe_coalesce(), 68)
+        self.assertEqual(_ped.file_system_probe_coalesce(0), 68)
+        self.assertRaises(ValueError, _ped.file_system_probe_coalesce, -1)
+        self.assertRaises(ValueError, _ped.file_system_probe_coalesce, 1025)
+        self.assertEqual(_ped.file_system_probe_coalesce(), 0)
+
+class FileSystemProbeCacheTestCase(RequiresFileSystem):
+    def setUp(self):
+        RequiresFileSystem.setUp(self)
+        self.addCleanup(_ped.file_system_probe_cache, False)
+
+        (fd, self.cachePath) = tempfile.mkstemp(prefix="temp-probe-cache-")
+        os.close(fd)
+        self.addCleanup(os.unlink, self.cachePath)
+
+    def runTest(self):
+        self.assertFalse(_ped.file_system_probe_cache(True))
+        self.assertTrue(_ped.file_system_probe_cache())
+        _ped.file_system_probe_cache_clear()
+
+        self.assertEqual(_ped.file_system_probe(self._geometry).name, "ext2")
+        self.assertEqual(_ped.file_system_probe(self._geometry).name, "ext2")
+
+        info = _ped.file_system_probe_cache_info()
+        self.assertEqual(info["hits"], 1)
+        self.assertEqual(info["misses"], 1)
+        self.assertEqual(info["size"], 1)
+
+        # A saved cache comes back warm.
+        self.assertEqual(_ped.file_system_probe_cache_save(self.cachePath), 1)
+        _ped.file_system_probe_cache_clear()
+        self.assertEqual(_ped.file_system_probe_cache_load(self.cachePath), 1)
+        self.assertEqual(_ped.file_system_probe(self._geometry).name, "ext2")
+        self.assertEqual(_ped.file_system_probe_cache_info()["hits"], 1)
+
+        # The key covers the whole signature window, not just the first
+        # sectors, so a change 32 KiB in misses too.
+        with open(self.path, "r+b") as f:
+            f.seek(32768)
+            f.write(b"\xff")
+
+        self.assertEqual(_ped.file_system_probe(self._geometry).name, "ext2")
+        self.assertEqual(_ped.file_system_probe_cache_info()["misses"], 1)
+
+        # Wiping the superblock changes the key, so the stale entry misses.
+        with open(self.path, "r+b") as f:
+            f.write(b"\0" * 4096)
+
+        self.assertRaises(_ped.FileSystemException, _ped.file_system_probe,
+                          self._geometry)
+        self.assertEqual(_ped.file_system_probe_cache_info()["misses"], 2)
+
+        with open(self.cachePath, "wb") as f:
+            f.write(b"not a cache")
+
+        self.assertRaises(ValueError, _ped.file_system_probe_cache_load,
+                          self.cachePath)
+
+        self.assertTrue(_ped.file_system_probe_cache(False))
+        self.assertEqual(_ped.file_system_probe_cache_info()["size"], 0)
+
 class FileSystemTypeGetTestCase(unittest.TestCase):
     def runTest(self):
         for f in ["affs0", "amufs", "apfs1", "asfs", "btrfs", "ext2", "ext3", "ext4", "fat16",
@@ -396,3 +463,131 @@ class UnitGetByNameTestCase(unittest.TestCase):
         self.assertEqual(_ped.unit_get_by_name('TB'), _ped.UNIT_TERABYTE)
 
         self.assertRaises(_ped.UnknownTypeException, _ped.unit_get_by_name, "blargle")
+
+class StatsTestCase(RequiresDevice):
+    def setUp(self):
+        RequiresDevice.setUp(self)
+        self.addCleanup(_ped.stats_enable, False)
+        self.addCleanup(_ped.stats_reset)
+
+    def runTest(self):
+        device_get = _ped.device_get
+        read = _ped.Geometry.read
+
+        self.assertFalse(_ped.stats_enable(True))
+        self.assertTrue(_ped.stats_enable())
+        _ped.stats_reset()
+
+        self.assertIsInstance(_ped.device_get(self.path), _ped.Device)
+        self.assertIsInstance(_ped.device_get(self.path), _ped.Device)
+
+        geom = _ped.Geometry(self._device, 0, 100)
+        self._device.open()
+        try:
+            geom.read(0, 2)
+        finally:
+            self._device.close()
+
+        stats = _ped.stats()
+        self.assertEqual(stats["device_get"]["calls"], 2)
+        self.assertEqual(sum(stats["device_get"]["histogram"]), 2)
+        self.assertGreaterEqual(stats["device_get"]["total"],
+                                stats["device_get"]["max"])
+        self.assertGreaterEqual(stats["device_get"]["objects"], 2)
+        self.assertEqual(stats["Geometry.read"]["calls"], 1)
+        self.assertEqual(stats["Geometry.read"]["bytes_read"],
+                         2 * self._device.sector_size)
+        self.assertNotIn("stats", stats)
+
+        _ped.stats_reset()
+        self.assertEqual(_ped.stats(), {})
+
+        # Turning it off puts the originals back.
+        self.assertTrue(_ped.stats_enable(False))
+        self.assertIs(_ped.device_get, device_get)
+        self.assertIs(_ped.Geometry.read, read)
+        _ped.device_get(self.path)
+        self.assertEqual(_ped.stats(), {})
+
+class TraceTestCase(RequiresDisk):
+    def setUp(self):
+        RequiresDisk.setUp(self)
+        self.addCleanup(_ped.trace_drain)
+        self.addCleanup(_ped.trace_enable, False)
+
+    def runTest(self):
+        self.assertFalse(_ped.trace_enable(True, 16))
+        self.assertTrue(_ped.trace_enable())
+        self.assertEqual(_ped.trace_drain(), [])
+
+        self.assertTrue(self._disk.commit_to_dev())
+        trace = _ped.trace_drain()
+        self.assertIn("write", [r[0] for r in trace])
+
+        for (op, start, count, seconds, call) in trace:
+            self.assertIn(op, ["read", "write", "sync", "sync_fast"])
+            self.assertGreaterEqual(start, 0)
+            self.assertGreaterEqual(count, 0)
+            self.assertGreaterEqual(seconds, 0)
+            self.assertEqual(call, "Disk.commit_to_dev")
+
+        _ped.disk_new(self._device)
+        trace = _ped.trace_drain()
+        self.assertIn(("read", 0, 1), [r[:3] for r in trace])
+        self.assertEqual(set(r[4] for r in trace), set(["disk_new"]))
+
+        # The ring keeps only the newest records.
+        for _ in range(20):
+            _ped.disk_new(self._device)
+
+        info = _ped.trace_info()
+        self.assertEqual(info["size"], 16)
+        self.assertEqual(info["pending"], 16)
+        self.assertGreater(info["dropped"], 0)
+        self.assertEqual(len(_ped.trace_drain()), 16)
+
+        # Records made before turning it off can still be drained.
+        _ped.disk_new(self._device)
+        self.assertTrue(_ped.trace_enable(False))
+        self.assertNotEqual(_ped.trace_drain(), [])
+        _ped.disk_new(self._device)
+        self.assertEqual(_ped.trace_drain(), [])
+        self.assertFalse(_ped.trace_info()["enabled"])
+
+        self.assertRaises(ValueError, _ped.trace_enable, True, 0)
+
+class LiveObjectsTestCase(RequiresDevice, LeakCheck):
+    def runTest(self):
+        counts = _ped.live_objects()
+        self.assertIn("Device", counts)
+        self.assertIn("Geometry", counts)
+
+        geom = _ped.Geometry(self._device, 0, 100)
+        self.assertEqual(_ped.live_objects()["Geometry"], counts["Geometry"] + 1)
+        del geom
+        self.assertEqual(_ped.live_objects()["Geometry"], counts["Geometry"])
+
+        self.assertIsInstance(_ped.native_memory(), int)
+
+        # Open, label, walk, commit and close the device.
+        def workload():
+            device = _ped.device_get(self.path)
+            device.open()
+
+            try:
+                disk = _ped.disk_new_fresh(device, _ped.disk_type_get("msdos"))
+                for (start, end) in [(64, 127), (130, 260)]:
+                    part = _ped.Partition(disk, _ped.PARTITION_NORMAL, start, end)
+                    disk.add_partition(part, _ped.constraint_exact(part.geom))
+
+                disk.commit()
+
+                disk = _ped.disk_new(device)
+                part = disk.next_partition()
+                while part:
+                    (part.num, part.type, part.geom.start, part.geom.end)
+                    part = disk.next_partition(part)
+            finally:
+                device.close()
+
+        self.assertNoLeaks(workload)
@@ -202,6 +202,17 @@ class DiskUnsetFlagTestCase(RequiresDisk):
         flag = self.disk.getFlag(parted.DISK_CYLINDER_ALIGNMENT)
         self.assertEqual(flag, False)
 
+class DiskGetSetFlagsTestCase(RequiresDisk):
+    def runTest(self):
+        # This test assumes an MSDOS label as given by RequiresDisk
+        mask = 1 << parted.DISK_CYLINDER_ALIGNMENT
+        self.disk.setFlags(mask)
+        self.assertEqual(self.disk.getFlags(), mask)
+        self.assertTrue(self.disk.getFlag(parted.DISK_CYLINDER_ALIGNMENT))
+
+        self.disk.setFlags(0)
+        self.assertEqual(self.disk.getFlags(), 0)
+
 class DiskIsFlagAvailableTestCase(RequiresDisk):
     def runTest(self):
         # This test assumes an MSDOS label as given by RequiresDisk
@@ -226,17 +237,29 @@ class DiskGetPrimaryPartitionsTestCase(unittest.TestCase):
         # TODO
         self.fail("Unimplemented test case.")
 
-@unittest.skip("Unimplemented test case.")
-class DiskGetRaidPartitionsTestCase(unittest.TestCase):
+class DiskFlaggedPartitionsTestCase(RequiresDisk):
+    def setUp(self):
+        super(DiskFlaggedPartitionsTestCase, self).setUp()
+
+        # This assumes an MSDOS label as given by RequiresDisk
+        for (start, flag) in [(100, parted.PARTITION_RAID),
+                              (200, parted.PARTITION_LVM),
+                              (300, None)]:
+            geom = parted.Geometry(self.device, start=start, length=100)
+            part = parted.Partition(self.disk, parted.PARTITION_NORMAL, geometry=geom)
+            self.disk.addPartition(part, parted.Constraint(exactGeom=geom))
+            if flag:
+                part.setFlag(flag)
+
+class DiskGetRaidPartitionsTestCase(DiskFlaggedPartitionsTestCase):
     def runTest(self):
-        # TODO
-        self.fail("Unimplemented test case.")
+        parts = self.disk.getRaidPartitions()
+        self.assertEqual([p.geometry.start for p in parts], [100])
 
-@unittest.skip("Unimplemented test case.")
-class DiskGetLVMPartitionsTestCase(unittest.TestCase):
+class DiskGetLVMPartitionsTestCase(DiskFlaggedPartitionsTestCase):
     def runTest(self):
-        # TODO
-        self.fail("Unimplemented test case.")
+        parts = self.disk.getLVMPartitions()
+        self.assertEqual([p.geometry.start for p in parts], [200])
 
 @unittest.skip("Unimplemented test case.")
 class DiskGetFreeSpaceRegionsTestCase(unittest.TestCase):
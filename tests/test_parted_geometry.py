@@ -58,11 +58,18 @@ class GeometryContainsSectorTestCase(unittest.TestCase):
         # TODO
         self.fail("Unimplemented test case.")
 
-@unittest.skip("Unimplemented test case.")
-class GeometryEqualTestCase(unittest.TestCase):
-    def runTest(self):
-        # TODO
-        self.fail("Unimplemented test case.")
+class GeometryEqualTestCase(RequiresDevice):
+    def runTest(self):
+        g1 = parted.Geometry(self.device, start=0, length=100)
+        g2 = parted.Geometry(parted.getDevice(self.path), start=0, length=100)
+        g3 = parted.Geometry(self.device, start=0, length=50)
+
+        self.assertEqual(g1, g2)
+        self.assertNotEqual(g1, g3)
+        self.assertEqual(hash(g1), hash(g2))
+        self.assertEqual(len(set([g1, g2, g3])), 2)
+        self.assertEqual(g1.device, g2.device)
+        self.assertEqual(hash(g1.device), hash(g2.device))
 
 @unittest.skip("Unimplemented test case.")
 class GeometryGetSizeTestCase(unittest.TestCase):
@@ -216,6 +216,27 @@ class PartitionGetLengthTestCase(RequiresDisk):
         self.assertEqual(part.getLength(), part.geometry.length)
         self.assertEqual(part.getLength(), length)
 
+class PartitionLazyTestCase(RequiresDisk):
+    """
+        Partitions read back from a disk have no __dict__ and build their
+        geometry, filesystem and disk on first access.
+    """
+    def runTest(self):
+        geom = parted.Geometry(self.device, start=100, length=100)
+        part = parted.Partition(self.disk, parted.PARTITION_NORMAL, geometry=geom)
+        self.disk.addPartition(part, parted.Constraint(exactGeom=geom))
+        self.disk.commit()
+        part = self.disk.partitions[0]
+
+        with self.assertRaises(AttributeError):
+            part.notAnAttribute = 1
+
+        self.assertIs(part.disk, self.disk)
+        self.assertIs(part.geometry, part.geometry)
+        self.assertIs(part.geometry.device, self.disk.device)
+        self.assertEqual(part.geometry.start, 100)
+        self.assertIsNone(part.fileSystem)
+
 @unittest.skip("Unimplemented test case.")
 class PartitionGetMaxAvailableSizeTestCase(unittest.TestCase):
     def runTest(self):
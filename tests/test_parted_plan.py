@@ -0,0 +1,78 @@
+#
+# Test cases for the methods in the parted.plan module itself
+#
+# Copyright (C) 2015  Red Hat, Inc.
+#
+# This copyrighted material is made available to anyone wishing to use,
+# modify, copy, or redistribute it subject to the terms and conditions of
+# the GNU General Public License v.2, or (at your option) any later version.
+# This program is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY expressed or implied, including the implied warranties of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+# Public License for more details.  You should have received a copy of the
+# GNU General Public License along with this program; if not, write to the
+# Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+# 02110-1301, USA.  Any Red Hat trademarks that are incorporated in the
+# source code or documentation are not subject to the GNU General Public
+# License and may only be used or replicated with the express permission of
+# Red Hat, Inc.
+#
+
+import parted
+
+from tests.baseclass import RequiresDevice
+
+# One class per method, multiple tests per class.  For these simple methods,
+# that seems like good organization.  More complicated methods may require
+# multiple classes and their own test suite.
+class LayoutPlanNewTestCase(RequiresDevice):
+    def runTest(self):
+        self.assertRaises(parted.DiskLabelException, parted.LayoutPlan,
+                          "blah", [{"size": None}])
+        self.assertRaises(parted.PartitionException, parted.LayoutPlan,
+                          "msdos", [])
+        self.assertRaises(parted.PartitionException, parted.LayoutPlan,
+                          "msdos", [{"size": None}, {"size": 10}])
+        self.assertRaises(parted.AlignmentException, parted.LayoutPlan,
+                          "msdos", [{"size": None}], alignment="blah")
+
+class LayoutPlanSolveTestCase(RequiresDevice):
+    def setUp(self):
+        RequiresDevice.setUp(self)
+        self.plan = parted.LayoutPlan("msdos",
+                                      [{"size": 100, "fs": "ext2"},
+                                       {"size": "25%"},
+                                       {"size": None}],
+                                      alignment="none")
+
+    def runTest(self):
+        solved = self.plan.solve(self.device)
+        self.assertEqual(len(solved), 3)
+
+        # Partitions are contiguous, in order, and stay on the device.
+        self.assertEqual(solved[0][1] - solved[0][0] + 1, 100)
+        self.assertEqual(solved[1][0], solved[0][1] + 1)
+        self.assertEqual(solved[2][0], solved[1][1] + 1)
+        self.assertEqual(solved[2][1], self.device.length - 1)
+
+        # A second solve for the same geometry comes from the cache.
+        self.assertIs(self.plan.solve(self.device), solved)
+        self.plan.invalidate()
+        self.assertIsNot(self.plan.solve(self.device), solved)
+        self.assertEqual(self.plan.solve(self.device), solved)
+
+class LayoutPlanApplyTestCase(RequiresDevice):
+    def runTest(self):
+        plan = parted.LayoutPlan("msdos",
+                                 [{"size": 100, "flags": [parted.PARTITION_BOOT]},
+                                  {"size": None}],
+                                 alignment="none")
+        disk = plan.apply(self.device, commit=False)
+        self.assertEqual(len(disk.partitions), 2)
+        self.assertTrue(disk.partitions[0].getFlag(parted.PARTITION_BOOT))
+        self.assertEqual((disk.partitions[1].geometry.start,
+                          disk.partitions[1].geometry.end),
+                         plan.solve(self.device)[1])
+
+        disks = plan.applyAll([self.device, self.device], commit=False)
+        self.assertEqual(len(disks), 2)